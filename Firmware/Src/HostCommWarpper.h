@@ -45,12 +45,33 @@ bool Fan_Control_Set_Curve_Point_Report(const uint8_t *buf, int32_t len);
 #define RGB_CONFIG_INFO_REPORT_ID               7
 #define RGB_CONFIG_HID_CHANNEL_MAP_REPORT_ID    8
 #define RGB_CONFIG_PHY_CHANNEL_MAP_REPORT_ID    9
+#define RGB_CONFIG_STATS_REPORT_ID              10
+#define RGB_CONFIG_TIMING_REPORT_ID             11
+#define RGB_CONFIG_CORRECTION_REPORT_ID         12
+#define RGB_CONFIG_POWER_REPORT_ID              13
+#define RGB_CONFIG_SEGMENT_REPORT_ID            14
+#define RGB_CONFIG_LAYOUT_REPORT_ID             15
+#define RGB_CONFIG_PHY_CHANNEL_FORMAT_REPORT_ID 16
 
 int32_t RGB_Config_Get_Info_Report(uint8_t *buf);
 int32_t RGB_Config_Get_Hid_Channel_Map_Report(uint8_t *buf);
 int32_t RGB_Config_Get_Phy_Channel_Map_Report(uint8_t *buf);
 bool RGB_Config_Set_Hid_Channel_Map_Report(const uint8_t *buf, int32_t len);
 bool RGB_Config_Set_Phy_Channel_Map_Report(const uint8_t *buf, int32_t len);
+int32_t RGB_Config_Get_Stats_Report(uint8_t *buf);
+bool RGB_Config_Set_Stats_Report(const uint8_t *buf, int32_t len);
+int32_t RGB_Config_Get_Timing_Report(uint8_t *buf);
+bool RGB_Config_Set_Timing_Report(const uint8_t *buf, int32_t len);
+int32_t RGB_Config_Get_Correction_Report(uint8_t *buf);
+bool RGB_Config_Set_Correction_Report(const uint8_t *buf, int32_t len);
+int32_t RGB_Config_Get_Power_Report(uint8_t *buf);
+bool RGB_Config_Set_Power_Report(const uint8_t *buf, int32_t len);
+int32_t RGB_Config_Get_Segment_Report(uint8_t *buf);
+bool RGB_Config_Set_Segment_Report(const uint8_t *buf, int32_t len);
+int32_t RGB_Config_Get_Layout_Report(uint8_t *buf);
+bool RGB_Config_Set_Layout_Report(const uint8_t *buf, int32_t len);
+int32_t RGB_Config_Get_Phy_Channel_Format_Report(uint8_t *buf);
+bool RGB_Config_Set_Phy_Channel_Format_Report(const uint8_t *buf, int32_t len);
 
 #define RGB_LAMP_ARRAY_ATTRIBUTES_REPORT_ID     1
 #define RGB_LAMP_ATTRIBUTES_REQUEST_REPORT_ID   2
@@ -58,13 +79,18 @@ bool RGB_Config_Set_Phy_Channel_Map_Report(const uint8_t *buf, int32_t len);
 #define RGB_LAMP_MULTI_UPDATE_REPORT_ID         4
 #define RGB_LAMP_RANGE_UPDATE_REPORT_ID         5
 #define RGB_LAMP_ARRAY_CONTROL_REPORT_ID        6
+#define RGB_LAMP_STREAM_REPORT_ID               7       // Output report, vendor collection next to the LampArray
+#define RGB_LAMP_OPS_REPORT_ID                  8       // Output report, vendor collection next to the LampArray
+#define RGB_LAMP_PALETTE_REPORT_ID              9       // Output report, vendor collection next to the LampArray
+#define RGB_LAMP_INDEX_REPORT_ID                10      // Output report, vendor collection next to the LampArray
 
 #define RGB_LAMP_MULTI_UPDATE_LAMP_COUNT        10
+#define RGB_LAMP_STREAM_SLICE_LAMP_COUNT        20      // Report ID and header included, a slice fills one 64 byte packet
+#define RGB_LAMP_OPS_BYTES                      60      // Report ID and header included, fills one 64 byte packet
+#define RGB_LAMP_PALETTE_SLICE_COLOR_COUNT      20      // Report ID and header included, a slice fills one 64 byte packet
+#define RGB_LAMP_INDEX_LAMP_COUNT               60      // Report ID and header included, fills one 64 byte packet
 
-#define RGB_LAMP_INSTANCES_COUNT                3
-#define RGB_LAMP_INSTANCE_0_LAMP_COUNT          128
-#define RGB_LAMP_INSTANCE_1_LAMP_COUNT          64
-#define RGB_LAMP_INSTANCE_2_LAMP_COUNT          64
+#define RGB_LAMP_INSTANCES_COUNT                3       // Lamps of each instance follow RGB_Hid_Channel_Lamp_Map
 
 int32_t RGB_Control_Get_Attr_Report(uint8_t instance, uint8_t *buf);
 int32_t RGB_Control_Get_Attributes_Response(uint8_t instance, uint8_t *buf);
@@ -72,5 +98,9 @@ bool RGB_Control_Set_Attr_Request_Lamp_ID(uint8_t instance, const uint8_t *buf,
 bool RGB_Control_Set_Multi_Update(uint8_t instance, const uint8_t *buf, int32_t len);
 bool RGB_Control_Set_Range_Update(uint8_t instance, const uint8_t *buf, int32_t len);
 bool RGB_Control_Set_Control_Mode(uint8_t instance, const uint8_t *buf, int32_t len);
+bool RGB_Control_Set_Stream_Slice(uint8_t instance, const uint8_t *buf, int32_t len);
+bool RGB_Control_Set_Ops_Update(uint8_t instance, const uint8_t *buf, int32_t len);
+bool RGB_Control_Set_Palette_Update(uint8_t instance, const uint8_t *buf, int32_t len);
+bool RGB_Control_Set_Index_Update(uint8_t instance, const uint8_t *buf, int32_t len);
 
 #endif
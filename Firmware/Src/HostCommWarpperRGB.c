@@ -6,6 +6,7 @@
 #include "HostCommWarpper.h"
 
 #include "RGBControl.h"
+#include "RGBOpStream.h"
 #include <string.h>
 #include "rl_usb.h"
 #include "cmsis_os.h"
@@ -102,12 +103,41 @@ typedef __packed struct
     uint8_t AutonomousMode;
 } LampArrayControlReport;
 
+typedef __packed struct
+{
+    uint8_t Sequence;           // Incremented by the host for each report, gaps count as lost slices
+    uint8_t Flags;              // bit0: commit the frame after this slice
+    uint8_t SliceId;            // Slice n starts at lamp n * RGB_LAMP_STREAM_SLICE_LAMP_COUNT
+    uint8_t Colors[RGB_LAMP_STREAM_SLICE_LAMP_COUNT][3]; // RGB, lamps past the end of the instance are ignored
+} LampStreamReport;
+
+typedef __packed struct
+{
+    uint8_t Flags;              // bit0: commit the frame after this report
+    uint16_t LampIdStart;       // Lamp the first op applies to
+    uint8_t Ops[RGB_LAMP_OPS_BYTES]; // See RGBOpStream.h
+} LampOpsReport;
+
+typedef __packed struct
+{
+    uint8_t Flags;              // bit0: commit the frame after this report
+    uint8_t FirstIndex;         // Palette entry of the first color, shared by all instances
+    uint8_t Colors[RGB_LAMP_PALETTE_SLICE_COLOR_COUNT][3]; // RGB, entries past RGB_INDEX_PALETTE_SIZE are ignored
+} LampPaletteReport;
+
+typedef __packed struct
+{
+    uint8_t Flags;              // bit0: commit the frame after this report
+    uint16_t LampIdStart;
+    uint8_t Indexes[RGB_LAMP_INDEX_LAMP_COUNT];  // Palette entry of each lamp, lamps past the end of the instance are ignored
+} LampIndexReport;
+
 static const LampAttributes RGB_Lamp_Attributes_Template = {
     0x00,                      // Lamp ID 0
     1,                         // PositionXInMicrometers
     1,                         // PositionYInMicrometers
     1,                         // PositionZInMicrometers
-    RGB_LAMP_TOTAL_COUNT * 36, // UpdateLatencyInMicroseconds <- assume 1.5us for 1bit in WS281X
+    0,                         // UpdateLatencyInMicroseconds <- from phy channel map, filled on request
     LampPurposeAccent,         // Lamp purpose: bit5 -> LampPurposePresentation, bit4 -> LampPurposeIllumination, bit3 -> LampPurposeStatus (Unread msg etc.),
                                //     bit2 - > LampPurposeBranding (Logo etc.), bit1 -> LampPurposeAccent (CaseFan, etc.), bit0 -> LampPurposeControl (Keys on board, etc.)
     0xFF,                      // RedLevelCount
@@ -117,8 +147,16 @@ static const LampAttributes RGB_Lamp_Attributes_Template = {
     1,                         // IsProgrammable <- No command will be sent if set to 0. LMAO XD
     0,                         // InputBinding
 };
-static const uint16_t RGB_Lamp_Count_By_Instances[] = {RGB_LAMP_INSTANCE_0_LAMP_COUNT, RGB_LAMP_INSTANCE_1_LAMP_COUNT, RGB_LAMP_INSTANCE_2_LAMP_COUNT};
 static uint16_t RGB_Attributes_Request_Report_Lamp_ID[] = {0, 0, 0};
+static uint16_t RGB_Stream_Next_Sequence[] = {0x100, 0x100, 0x100};  // Out of byte range until the first report
+
+/* Map of an instance, set by the config report under RGB_Lamp_Colors_Mutex. Writers read count and paddings in one hold */
+static inline uint16_t RGB_Hid_Instance_Get_Lamp_Count(uint8_t instance)
+{
+    if (instance >= RGB_LAMP_INSTANCES_COUNT || instance >= RGB_CONTROL_HID_CHANNELS_COUNT) return 0;
+
+    return RGB_Hid_Channel_Lamp_Map[instance][1];
+}
 
 static inline uint16_t RGB_Hid_Instance_Get_Lamp_Paddings(uint8_t instance)
 {
@@ -127,23 +165,45 @@ static inline uint16_t RGB_Hid_Instance_Get_Lamp_Paddings(uint8_t instance)
     return RGB_Hid_Channel_Lamp_Map[instance][0];
 }
 
+static void RGB_Hid_Instance_Get_Lamp_Position(uint8_t instance, uint16_t lamp_id, uint32_t position[3])
+{
+    if (!RGB_Control_Get_Lamp_Position(RGB_Hid_Instance_Get_Lamp_Paddings(instance) + lamp_id, position))
+    { // 1 mm line
+        position[0] = lamp_id * 1000;
+        position[1] = 1000;
+        position[2] = 1000;
+    }
+}
+
 int32_t RGB_Control_Get_Attr_Report(uint8_t instance, uint8_t *buf)
 {
     LampArrayAttributesReport *data = (LampArrayAttributesReport *)buf;
 
-    data->LampCount = RGB_Lamp_Count_By_Instances[instance];
+    data->LampCount = RGB_Hid_Instance_Get_Lamp_Count(instance);
 #if RGB_CUSTOM_LAMP_POSITIONS
     data->BoundingBoxWidthInMicrometers = RGB_BOUNDING_BOX_WIDTH_X;
     data->BoundingBoxHeightInMicrometers = RGB_BOUNDING_BOX_HEIGHT_Z;
     data->BoundingBoxDepthInMicrometers = RGB_BOUNDING_BOX_DEPTH_Y;
 #else
-    data->BoundingBoxWidthInMicrometers = RGB_Lamp_Count_By_Instances[instance] * 1000;
-    data->BoundingBoxHeightInMicrometers = 1000;
-    data->BoundingBoxDepthInMicrometers = 1000;
+    // Smallest box holding all lamps, the layout can change at runtime
+    uint32_t box[3] = {1000, 1000, 1000};
+    for (uint16_t i = 0; i < data->LampCount; i++)
+    {
+        uint32_t position[3];
+        RGB_Hid_Instance_Get_Lamp_Position(instance, i, position);
+        for (int k = 0; k < 3; k++)
+        {
+            if (position[k] + 1000 > box[k])
+                box[k] = position[k] + 1000;
+        }
+    }
+    data->BoundingBoxWidthInMicrometers = box[0];
+    data->BoundingBoxHeightInMicrometers = box[1];
+    data->BoundingBoxDepthInMicrometers = box[2];
 #endif
     data->LampArrayKind = LampArrayKindChassis;
     // data->LampArrayKind = LampArrayKindPeripheral;
-    data->MinUpdateIntervalInMicroseconds = RGB_MIN_UPDATE_INTERVAL;
+    data->MinUpdateIntervalInMicroseconds = RGB_Control_Get_Min_Update_Interval();
 
     return sizeof(LampArrayAttributesReport);
 }
@@ -155,28 +215,27 @@ int32_t RGB_Control_Get_Attributes_Response(uint8_t instance, uint8_t *buf)
         Referer: Page 337, https://www.usb.org/sites/default/files/hut1_4.pdf
     */
 
-    if (RGB_Attributes_Request_Report_Lamp_ID[instance] >= RGB_Lamp_Count_By_Instances[instance])
+    uint16_t lamp_count = RGB_Hid_Instance_Get_Lamp_Count(instance);
+    if (RGB_Attributes_Request_Report_Lamp_ID[instance] >= lamp_count)
     {
-        // Make sure we are not reading sth else
-        RGB_Attributes_Request_Report_Lamp_ID[instance] = RGB_Lamp_Count_By_Instances[instance] - 1;
+        // Make sure we are not reading sth else, the map may have shrunk since the request
+        RGB_Attributes_Request_Report_Lamp_ID[instance] = lamp_count ? lamp_count - 1 : 0;
     }
 
     memcpy(buf, &RGB_Lamp_Attributes_Template, sizeof(LampAttributes));
 
     LampAttributes *_buf = (LampAttributes *)buf;
     _buf->LampId = RGB_Attributes_Request_Report_Lamp_ID[instance];
-#if RGB_CUSTOM_LAMP_POSITIONS
-    _buf->PositionXInMicrometers = RGB_Lamp_Positions[RGB_Hid_Instance_Get_Lamp_Paddings(instance) + RGB_Attributes_Request_Report_Lamp_ID[instance]][0] * 1000;
-    _buf->PositionYInMicrometers = RGB_Lamp_Positions[RGB_Hid_Instance_Get_Lamp_Paddings(instance) + RGB_Attributes_Request_Report_Lamp_ID[instance]][1] * 1000;
-    _buf->PositionZInMicrometers = RGB_Lamp_Positions[RGB_Hid_Instance_Get_Lamp_Paddings(instance) + RGB_Attributes_Request_Report_Lamp_ID[instance]][2] * 1000;
-#else
-    _buf->PositionXInMicrometers = RGB_Attributes_Request_Report_Lamp_ID[instance] * 1000;
-    _buf->PositionYInMicrometers = 1000;
-    _buf->PositionZInMicrometers = 1000;
-#endif
+    _buf->UpdateLatencyInMicroseconds = RGB_Control_Get_Update_Latency();
+
+    uint32_t position[3];
+    RGB_Hid_Instance_Get_Lamp_Position(instance, RGB_Attributes_Request_Report_Lamp_ID[instance], position);
+    _buf->PositionXInMicrometers = position[0];
+    _buf->PositionYInMicrometers = position[1];
+    _buf->PositionZInMicrometers = position[2];
 
     RGB_Attributes_Request_Report_Lamp_ID[instance]++;
-    if (RGB_Attributes_Request_Report_Lamp_ID[instance] >= RGB_Lamp_Count_By_Instances[instance])
+    if (RGB_Attributes_Request_Report_Lamp_ID[instance] >= lamp_count)
     {
         // Reached the end of lamps, return to 0 and next response will be the last response.
         RGB_Attributes_Request_Report_Lamp_ID[instance] = 0;
@@ -190,11 +249,12 @@ bool RGB_Control_Set_Attr_Request_Lamp_ID(uint8_t instance, const uint8_t *buf,
     if (len != sizeof(LampAttributesRequestReport))
         return false;
 
+    uint16_t lamp_count = RGB_Hid_Instance_Get_Lamp_Count(instance);
     RGB_Attributes_Request_Report_Lamp_ID[instance] = ((LampAttributesRequestReport *)buf)->LampId;
 
-    if (RGB_Attributes_Request_Report_Lamp_ID[instance] >= RGB_Lamp_Count_By_Instances[instance])
+    if (RGB_Attributes_Request_Report_Lamp_ID[instance] >= lamp_count)
     {
-        RGB_Attributes_Request_Report_Lamp_ID[instance] = RGB_Lamp_Count_By_Instances[instance] - 1;
+        RGB_Attributes_Request_Report_Lamp_ID[instance] = lamp_count ? lamp_count - 1 : 0;
     }
 
     return true;
@@ -209,20 +269,34 @@ bool RGB_Control_Set_Multi_Update(uint8_t instance, const uint8_t *buf, int32_t
     if (_buf->LampCount > RGB_LAMP_MULTI_UPDATE_LAMP_COUNT)
         return false;
 
+    // The map changes under the mutex, read it once in the same hold as the writes
+    osMutexWait(RGB_Lamp_Colors_Mutex, osWaitForever);
+    uint16_t lamp_count = RGB_Hid_Instance_Get_Lamp_Count(instance);
+    uint16_t paddings = RGB_Hid_Instance_Get_Lamp_Paddings(instance);
     for (int i = 0; i < _buf->LampCount; i++)
     {
-        if (_buf->LampIds[i] >= RGB_Lamp_Count_By_Instances[instance])
+        if (_buf->LampIds[i] >= lamp_count)
+        {
+            osMutexRelease(RGB_Lamp_Colors_Mutex);
             return false;
-
-        RGB_Lamp_Colors[RGB_Hid_Instance_Get_Lamp_Paddings(instance) + _buf->LampIds[i] * 3] = _buf->UpdateColors[i].RedChannel;
-        RGB_Lamp_Colors[RGB_Hid_Instance_Get_Lamp_Paddings(instance) + _buf->LampIds[i] * 3 + 1] = _buf->UpdateColors[i].GreenChannel;
-        RGB_Lamp_Colors[RGB_Hid_Instance_Get_Lamp_Paddings(instance) + _buf->LampIds[i] * 3 + 2] = _buf->UpdateColors[i].BlueChannel;
+        }
     }
 
-    if (_buf->LampUpdateFlags & 1)
+    uint16_t first = 0xFFFF, last = 0;
+    for (int i = 0; i < _buf->LampCount; i++)
     {
-        osMessagePut(RGB_Update_Msg_Queue, 1, 0);
+        uint16_t lamp = paddings + _buf->LampIds[i];
+        RGB_Control_Set_Lamp(lamp, _buf->UpdateColors[i].RedChannel, _buf->UpdateColors[i].GreenChannel, _buf->UpdateColors[i].BlueChannel);
+
+        if (lamp < first)
+            first = lamp;
+        if (lamp > last)
+            last = lamp;
     }
+    // Post before releasing, a commit from another instance then never sends lamps without their update
+    if (_buf->LampCount > 0 || (_buf->LampUpdateFlags & 1))
+        RGB_Control_Post_Update(first, last, _buf->LampUpdateFlags & 1); // first > last if no lamps
+    osMutexRelease(RGB_Lamp_Colors_Mutex);
 
     return true;
 }
@@ -236,20 +310,22 @@ bool RGB_Control_Set_Range_Update(uint8_t instance, const uint8_t *buf, int32_t
 
     if (_buf->LampIdStart > _buf->LampIdEnd)
         return false;
-    if (_buf->LampIdStart > RGB_Lamp_Count_By_Instances[instance] || _buf->LampIdStart >= RGB_Lamp_Count_By_Instances[instance])
-        return false;
 
-    for (int i = _buf->LampIdStart; i <= _buf->LampIdEnd; i++)
+    osMutexWait(RGB_Lamp_Colors_Mutex, osWaitForever);
+    uint16_t paddings = RGB_Hid_Instance_Get_Lamp_Paddings(instance);
+    if (_buf->LampIdEnd >= RGB_Hid_Instance_Get_Lamp_Count(instance))
     {
-        RGB_Lamp_Colors[RGB_Hid_Instance_Get_Lamp_Paddings(instance) + i * 3] = _buf->UpdateColor.RedChannel;
-        RGB_Lamp_Colors[RGB_Hid_Instance_Get_Lamp_Paddings(instance) + i * 3 + 1] = _buf->UpdateColor.GreenChannel;
-        RGB_Lamp_Colors[RGB_Hid_Instance_Get_Lamp_Paddings(instance) + i * 3 + 2] = _buf->UpdateColor.BlueChannel;
+        osMutexRelease(RGB_Lamp_Colors_Mutex);
+        return false;
     }
 
-    if (_buf->LampUpdateFlags & 1)
+    for (int i = _buf->LampIdStart; i <= _buf->LampIdEnd; i++)
     {
-        osMessagePut(RGB_Update_Msg_Queue, 1, 0);
+        RGB_Control_Set_Lamp(paddings + i,
+                             _buf->UpdateColor.RedChannel, _buf->UpdateColor.GreenChannel, _buf->UpdateColor.BlueChannel);
     }
+    RGB_Control_Post_Update(paddings + _buf->LampIdStart, paddings + _buf->LampIdEnd, _buf->LampUpdateFlags & 1);
+    osMutexRelease(RGB_Lamp_Colors_Mutex);
 
     return true;
 }
@@ -264,3 +340,136 @@ bool RGB_Control_Set_Control_Mode(uint8_t instance, const uint8_t *buf, int32_t
 
     return true;
 }
+
+bool RGB_Control_Set_Stream_Slice(uint8_t instance, const uint8_t *buf, int32_t len)
+{
+    if (len != sizeof(LampStreamReport) || instance >= RGB_LAMP_INSTANCES_COUNT)
+        return false;
+
+    LampStreamReport *_buf = (LampStreamReport *)buf;
+
+    osMutexWait(RGB_Lamp_Colors_Mutex, osWaitForever);  // Stats are shared with the other instances' threads, the map changes under it
+    if (RGB_Stream_Next_Sequence[instance] <= 0xFF)
+        RGB_Frame_Stats.StreamLost += (uint8_t)(_buf->Sequence - RGB_Stream_Next_Sequence[instance]);
+    RGB_Stream_Next_Sequence[instance] = (uint8_t)(_buf->Sequence + 1);
+
+    uint16_t lamp_count = RGB_Hid_Instance_Get_Lamp_Count(instance);
+    uint16_t start = _buf->SliceId * RGB_LAMP_STREAM_SLICE_LAMP_COUNT;
+    uint16_t lamps = 0;
+    if (start < lamp_count)
+        lamps = (lamp_count - start < RGB_LAMP_STREAM_SLICE_LAMP_COUNT) ? lamp_count - start : RGB_LAMP_STREAM_SLICE_LAMP_COUNT;
+
+    if (lamps == 0 && !(_buf->Flags & 1))
+    {
+        osMutexRelease(RGB_Lamp_Colors_Mutex);
+        return false; // Slice past the end of the instance
+    }
+
+    uint16_t first = RGB_Hid_Instance_Get_Lamp_Paddings(instance) + start;
+    for (int i = 0; i < lamps; i++)
+        RGB_Control_Set_Lamp(first + i, _buf->Colors[i][0], _buf->Colors[i][1], _buf->Colors[i][2]);
+    // Post before releasing, a commit from another instance then never sends lamps without their update
+    if (lamps > 0)
+        RGB_Control_Post_Update(first, first + lamps - 1, _buf->Flags & 1);
+    else
+        RGB_Control_Post_Update(0xFFFF, 0, 1); // Commit only, first + lamps - 1 would wrap at lamp 0
+    osMutexRelease(RGB_Lamp_Colors_Mutex);
+
+    return true;
+}
+
+/* Op stream spans, RGB_Lamp_Colors_Mutex held */
+static void RGB_Control_Set_Lamp_Span(uint16_t lamp, uint16_t count, const uint8_t *colors, uint8_t stride)
+{
+    for (int i = 0; i < count; i++, colors += stride)
+        RGB_Control_Set_Lamp(lamp + i, colors[0], colors[1], colors[2]);
+}
+
+bool RGB_Control_Set_Ops_Update(uint8_t instance, const uint8_t *buf, int32_t len)
+{
+    if (len != sizeof(LampOpsReport) || instance >= RGB_LAMP_INSTANCES_COUNT)
+        return false;
+
+    LampOpsReport *_buf = (LampOpsReport *)buf;
+    uint16_t first, last;
+
+    // Runs in the HID class thread of the instance, read the map, apply and post in one mutex hold
+    osMutexWait(RGB_Lamp_Colors_Mutex, osWaitForever);
+    uint16_t paddings = RGB_Hid_Instance_Get_Lamp_Paddings(instance);
+    uint16_t lamp_count = paddings + RGB_Hid_Instance_Get_Lamp_Count(instance);
+
+    // Validate the whole stream first, a bad report changes nothing
+    if (_buf->LampIdStart > lamp_count - paddings ||
+        !RGB_Op_Stream_Decode(_buf->Ops, sizeof(_buf->Ops), paddings + _buf->LampIdStart, lamp_count, NULL, &first, &last))
+    {
+        osMutexRelease(RGB_Lamp_Colors_Mutex);
+        return false;
+    }
+
+    if (first <= last)
+        RGB_Op_Stream_Decode(_buf->Ops, sizeof(_buf->Ops), paddings + _buf->LampIdStart, lamp_count, RGB_Control_Set_Lamp_Span, &first, &last);
+    if (first <= last || (_buf->Flags & 1))
+        RGB_Control_Post_Update(first, last, _buf->Flags & 1); // first > last if no lamps
+    osMutexRelease(RGB_Lamp_Colors_Mutex);
+
+    return true;
+}
+
+bool RGB_Control_Set_Palette_Update(uint8_t instance, const uint8_t *buf, int32_t len)
+{
+    if (len != sizeof(LampPaletteReport))
+        return false;
+
+    LampPaletteReport *_buf = (LampPaletteReport *)buf;
+#if RGB_INDEX_PALETTE_SIZE < 256
+    if (_buf->FirstIndex >= RGB_INDEX_PALETTE_SIZE)
+        return false;
+#endif
+
+    uint16_t count = RGB_INDEX_PALETTE_SIZE - _buf->FirstIndex;
+    if (count > RGB_LAMP_PALETTE_SLICE_COLOR_COUNT)
+        count = RGB_LAMP_PALETTE_SLICE_COLOR_COUNT;
+
+    return RGB_Control_Set_Palette(_buf->FirstIndex, count, (const uint8_t (*)[RGB_CHANNELS_PER_LAMP])_buf->Colors, _buf->Flags & 1);
+}
+
+bool RGB_Control_Set_Index_Update(uint8_t instance, const uint8_t *buf, int32_t len)
+{
+    if (len != sizeof(LampIndexReport) || instance >= RGB_LAMP_INSTANCES_COUNT)
+        return false;
+
+    LampIndexReport *_buf = (LampIndexReport *)buf;
+    osMutexWait(RGB_Lamp_Colors_Mutex, osWaitForever); // The map changes under it, read it once in the same hold as the writes
+    uint16_t lamp_count = RGB_Hid_Instance_Get_Lamp_Count(instance);
+    uint16_t lamps = 0;
+    if (_buf->LampIdStart < lamp_count)
+        lamps = (lamp_count - _buf->LampIdStart < RGB_LAMP_INDEX_LAMP_COUNT) ? lamp_count - _buf->LampIdStart : RGB_LAMP_INDEX_LAMP_COUNT;
+
+    if (lamps == 0 && !(_buf->Flags & 1))
+    {
+        osMutexRelease(RGB_Lamp_Colors_Mutex);
+        return false; // Past the end of the instance
+    }
+
+#if RGB_INDEX_PALETTE_SIZE < 256
+    for (int i = 0; i < lamps; i++)
+    {
+        if (_buf->Indexes[i] >= RGB_INDEX_PALETTE_SIZE)
+        {
+            osMutexRelease(RGB_Lamp_Colors_Mutex);
+            return false;
+        }
+    }
+#endif
+
+    uint16_t first = RGB_Hid_Instance_Get_Lamp_Paddings(instance) + _buf->LampIdStart;
+    for (int i = 0; i < lamps; i++)
+        RGB_Control_Set_Lamp_Index(first + i, _buf->Indexes[i]);   // Palette held still by the mutex
+    if (lamps > 0)
+        RGB_Control_Post_Update(first, first + lamps - 1, _buf->Flags & 1);
+    else
+        RGB_Control_Post_Update(0xFFFF, 0, 1); // Commit only, first + lamps - 1 would wrap at lamp 0
+    osMutexRelease(RGB_Lamp_Colors_Mutex);
+
+    return true;
+}
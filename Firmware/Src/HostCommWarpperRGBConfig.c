@@ -32,8 +32,84 @@ typedef __packed struct
     uint16_t RgbPhyChannelLedCount;
 } RgbPhyChannelMapReport;
 
+typedef __packed struct
+{
+    uint8_t RgbStatsFlag;       // operational flags, bit0: clear counters
+    uint32_t RgbStatsFrames;
+    uint32_t RgbStatsUnderruns; // DMA underruns, ISR deadline missed. Wiring faults don't count here
+    uint32_t RgbStatsRetries;
+    uint32_t RgbStatsTimeouts;
+    uint32_t RgbStatsStreamLost;
+} RgbStatsReport;
+
+typedef __packed struct
+{
+    uint8_t RgbTimingFlag;      // operational flags, bit0: update; bit1: write to flash
+    uint8_t RgbTimingProfile;   // RGB_WS2812_TIMING_*
+    uint16_t RgbTimingBitTime;  // In Nanoseconds, read only
+    uint16_t RgbTimingResetTime;// In Microseconds, read only
+} RgbTimingReport;
+
+typedef __packed struct
+{
+    uint8_t RgbCorrectionFlag;          // operational flags, bit0: update; bit1: write to flash
+    uint8_t RgbCorrectionPhyChannelId;  // Channel of the gains
+    uint8_t RgbCorrectionGamma;         // In tenths, 10 for linear
+    uint8_t RgbCorrectionBrightness;
+    uint8_t RgbCorrectionGainRed;
+    uint8_t RgbCorrectionGainGreen;
+    uint8_t RgbCorrectionGainBlue;
+    uint8_t RgbCorrectionDither;        // 1: temporal dither, the lamps are refreshed continuously
+} RgbCorrectionReport;
+
+typedef __packed struct
+{
+    uint8_t RgbPowerFlag;               // operational flags, bit0: update; bit1: write to flash
+    uint8_t RgbPowerMilliampsPerColor;  // 1 color of 1 lamp at full
+    uint8_t RgbPowerScale;              // In percent, applied to the last frame. Read only
+    uint16_t RgbPowerBudget;            // In Milliamperes, 0 for no limit
+    uint16_t RgbPowerEstimate;          // In Milliamperes, current colors without limiting. Read only
+} RgbPowerReport;
+
+typedef __packed struct
+{
+    uint8_t RgbSegmentFlag;         // operational flags, bit0: update; bit1: write to flash
+    uint8_t RgbSegmentId;
+    uint8_t RgbSegmentPhyChannelId; // Appended to this channel after its phy map lamps, 0xFF for unused
+    uint8_t RgbSegmentMode;         // RGB_SEGMENT_*
+    uint8_t RgbSegmentWidth;        // Lamps per row, serpentine only
+    uint16_t RgbSegmentStartId;
+    uint16_t RgbSegmentLedCount;
+} RgbSegmentReport;
+
+typedef __packed struct
+{
+    uint8_t RgbLayoutFlag;          // operational flags, bit0: update; bit1: write to flash
+    uint8_t RgbLayoutShapeId;
+    uint8_t RgbLayoutShape;         // RGB_LAYOUT_*
+    uint8_t RgbLayoutParam;         // Grid: lamps per row; Ring: angle of the first lamp in 1/256 turns
+    uint16_t RgbLayoutFirstLampId;
+    uint16_t RgbLayoutLampCount;
+    uint16_t RgbLayoutOriginX;      // In tenths of Millimeters
+    uint16_t RgbLayoutOriginY;
+    uint16_t RgbLayoutOriginZ;
+    int16_t RgbLayoutStepX;         // In tenths of Millimeters. Ring: radius
+    int16_t RgbLayoutStepY;         // In tenths of Millimeters. Ring: < 0 for clockwise
+} RgbLayoutReport;
+
+typedef __packed struct
+{
+    uint8_t RgbPhyChannelFormatFlag;    // operational flags, bit0: update; bit1: write to flash
+    uint8_t RgbPhyChannelId;
+    uint8_t RgbPhyChannelFormat;        // RGB_PIXEL_FORMAT_*
+} RgbPhyChannelFormatReport;
+
 static uint8_t RGB_Config_Hid_Channel_Map_Report_Offset = 0;
 static uint8_t RGB_Config_Phy_Channel_Map_Report_Offset = 0;
+static uint8_t RGB_Config_Correction_Report_Offset = 0;
+static uint8_t RGB_Config_Segment_Report_Offset = 0;
+static uint8_t RGB_Config_Layout_Report_Offset = 0;
+static uint8_t RGB_Config_Phy_Channel_Format_Report_Offset = 0;
 
 
 int32_t RGB_Config_Get_Info_Report(uint8_t *buf)
@@ -89,12 +165,22 @@ bool RGB_Config_Set_Hid_Channel_Map_Report(const uint8_t *buf, int32_t len)
     if (_buf->RgbHidChannelId >= RGB_CONTROL_HID_CHANNELS_COUNT)
         return false;
 
+    uint16_t map[RGB_CONTROL_HID_CHANNELS_COUNT][2];
+    memcpy(map, RGB_Hid_Channel_Lamp_Map, sizeof(map));
+    map[_buf->RgbHidChannelId][0] = _buf->RgbHidChannelStartId;
+    map[_buf->RgbHidChannelId][1] = _buf->RgbHidChannelLedCount;
+    if (!RGB_Control_Hid_Channel_Map_Valid((const uint16_t (*)[2])map))
+        return false;
+
     RGB_Config_Hid_Channel_Map_Report_Offset = _buf->RgbHidChannelId;
 
     if ((_buf->RgbHidChannelFlag) & 1)
     {
+        // LampArray instances follow the map, hosts see the new lamp count on their next attributes read
+        osMutexWait(RGB_Lamp_Colors_Mutex, osWaitForever); // Output reports read both fields in one hold
         RGB_Hid_Channel_Lamp_Map[RGB_Config_Hid_Channel_Map_Report_Offset][0] = _buf->RgbHidChannelStartId;
         RGB_Hid_Channel_Lamp_Map[RGB_Config_Hid_Channel_Map_Report_Offset][1] = _buf->RgbHidChannelLedCount;
+        osMutexRelease(RGB_Lamp_Colors_Mutex);
     }
 
     if ((_buf->RgbHidChannelFlag >> 1) & 1)
@@ -113,13 +199,20 @@ bool RGB_Config_Set_Phy_Channel_Map_Report(const uint8_t *buf, int32_t len)
     RgbPhyChannelMapReport *_buf = (RgbPhyChannelMapReport*)buf;
     if (_buf->RgbPhyChannelId >= RGB_CONTROL_PHY_CHANNELS_COUNT)
         return false;
+    if (_buf->RgbPhyChannelStartId + _buf->RgbPhyChannelLedCount > RGB_LAMP_TOTAL_COUNT)
+        return false;
 
     RGB_Config_Phy_Channel_Map_Report_Offset = _buf->RgbPhyChannelId;
 
     if ((_buf->RgbPhyChannelFlag) & 1)
     {
+        osMutexWait(RGB_Lamp_Colors_Mutex, osWaitForever); // Map and color sums change together
         RGB_Phy_Channel_Lamp_Map[RGB_Config_Phy_Channel_Map_Report_Offset][0] = _buf->RgbPhyChannelStartId;
         RGB_Phy_Channel_Lamp_Map[RGB_Config_Phy_Channel_Map_Report_Offset][1] = _buf->RgbPhyChannelLedCount;
+        RGB_Control_Update_Power_Sums();
+        osMutexRelease(RGB_Lamp_Colors_Mutex);
+        RGB_Control_Update_Timing();
+        RGB_Control_Segments_Changed();
     }
 
     if ((_buf->RgbPhyChannelFlag >> 1) & 1)
@@ -129,3 +222,326 @@ bool RGB_Config_Set_Phy_Channel_Map_Report(const uint8_t *buf, int32_t len)
 
     return true;
 }
+
+int32_t RGB_Config_Get_Stats_Report(uint8_t *buf)
+{
+    RgbStatsReport *_buf = (RgbStatsReport*)buf;
+
+    _buf->RgbStatsFlag = 0;
+    _buf->RgbStatsFrames = RGB_Frame_Stats.Frames;
+    _buf->RgbStatsUnderruns = RGB_Frame_Stats.Underruns;
+    _buf->RgbStatsRetries = RGB_Frame_Stats.Retries;
+    _buf->RgbStatsTimeouts = RGB_Frame_Stats.Timeouts;
+    _buf->RgbStatsStreamLost = RGB_Frame_Stats.StreamLost;
+
+    return sizeof(RgbStatsReport);
+}
+
+bool RGB_Config_Set_Stats_Report(const uint8_t *buf, int32_t len)
+{
+    if (len != sizeof(RgbStatsReport))
+        return false;
+
+    RgbStatsReport *_buf = (RgbStatsReport*)buf;
+
+    if ((_buf->RgbStatsFlag) & 1)
+    {
+        RGB_Control_Clear_Stats();
+    }
+
+    return true;
+}
+
+int32_t RGB_Config_Get_Timing_Report(uint8_t *buf)
+{
+    RgbTimingReport *_buf = (RgbTimingReport*)buf;
+    const RGB_WS2812_Timing *timing = &RGB_WS2812_Timing_Profiles[RGB_Timing_Profile];
+
+    _buf->RgbTimingFlag = 0;
+    _buf->RgbTimingProfile = RGB_Timing_Profile;
+    _buf->RgbTimingBitTime = RGB_WS2812_BIT_TIME_NS(timing);
+    _buf->RgbTimingResetTime = RGB_WS2812_BIT_TIME_NS(timing) * RGB_WS2812_RESET_BITS(timing) / 1000;
+
+    return sizeof(RgbTimingReport);
+}
+
+bool RGB_Config_Set_Timing_Report(const uint8_t *buf, int32_t len)
+{
+    if (len != sizeof(RgbTimingReport))
+        return false;
+
+    RgbTimingReport *_buf = (RgbTimingReport*)buf;
+
+    if ((_buf->RgbTimingFlag) & 1)
+    {
+        if (!RGB_Control_Set_Timing_Profile(_buf->RgbTimingProfile))
+            return false;
+    }
+
+    if ((_buf->RgbTimingFlag >> 1) & 1)
+    {
+        RGB_Control_Save_Settings_Flash();
+    }
+
+    return true;
+}
+
+int32_t RGB_Config_Get_Correction_Report(uint8_t *buf)
+{
+    RgbCorrectionReport *_buf = (RgbCorrectionReport*)buf;
+
+    _buf->RgbCorrectionFlag = 0;
+    _buf->RgbCorrectionPhyChannelId = RGB_Config_Correction_Report_Offset;
+    _buf->RgbCorrectionGamma = RGB_Correction.Gamma;
+    _buf->RgbCorrectionBrightness = RGB_Correction.Brightness;
+    _buf->RgbCorrectionGainRed = RGB_Correction.Gain[RGB_Config_Correction_Report_Offset][0];
+    _buf->RgbCorrectionGainGreen = RGB_Correction.Gain[RGB_Config_Correction_Report_Offset][1];
+    _buf->RgbCorrectionGainBlue = RGB_Correction.Gain[RGB_Config_Correction_Report_Offset][2];
+    _buf->RgbCorrectionDither = RGB_Correction.Dither;
+
+    if (RGB_Config_Correction_Report_Offset + 1 >= RGB_CONTROL_PHY_CHANNELS_COUNT)
+        RGB_Config_Correction_Report_Offset = 0;
+    else
+        RGB_Config_Correction_Report_Offset += 1;
+
+    return sizeof(RgbCorrectionReport);
+}
+
+bool RGB_Config_Set_Correction_Report(const uint8_t *buf, int32_t len)
+{
+    if (len != sizeof(RgbCorrectionReport))
+        return false;
+
+    RgbCorrectionReport *_buf = (RgbCorrectionReport*)buf;
+    if (_buf->RgbCorrectionPhyChannelId >= RGB_CONTROL_PHY_CHANNELS_COUNT)
+        return false;
+
+    RGB_Config_Correction_Report_Offset = _buf->RgbCorrectionPhyChannelId;
+
+    if ((_buf->RgbCorrectionFlag) & 1)
+    {
+        if (_buf->RgbCorrectionGamma == 0 || _buf->RgbCorrectionDither > 1)
+            return false;
+
+        RGB_Correction.Gamma = _buf->RgbCorrectionGamma;
+        RGB_Correction.Brightness = _buf->RgbCorrectionBrightness;
+        RGB_Correction.Gain[RGB_Config_Correction_Report_Offset][0] = _buf->RgbCorrectionGainRed;
+        RGB_Correction.Gain[RGB_Config_Correction_Report_Offset][1] = _buf->RgbCorrectionGainGreen;
+        RGB_Correction.Gain[RGB_Config_Correction_Report_Offset][2] = _buf->RgbCorrectionGainBlue;
+        RGB_Correction.Dither = _buf->RgbCorrectionDither;
+        RGB_Control_Correction_Changed();
+    }
+
+    if ((_buf->RgbCorrectionFlag >> 1) & 1)
+    {
+        RGB_Control_Save_Settings_Flash();
+    }
+
+    return true;
+}
+
+int32_t RGB_Config_Get_Power_Report(uint8_t *buf)
+{
+    RgbPowerReport *_buf = (RgbPowerReport*)buf;
+    uint32_t estimate = RGB_Control_Get_Power_Estimate();
+
+    _buf->RgbPowerFlag = 0;
+    _buf->RgbPowerMilliampsPerColor = RGB_Power.MilliampsPerColor;
+    _buf->RgbPowerScale = RGB_Control_Get_Power_Scale() * 100 / 256;
+    _buf->RgbPowerBudget = RGB_Power.BudgetMilliamps;
+    _buf->RgbPowerEstimate = estimate > 0xFFFF ? 0xFFFF : estimate;
+
+    return sizeof(RgbPowerReport);
+}
+
+bool RGB_Config_Set_Power_Report(const uint8_t *buf, int32_t len)
+{
+    if (len != sizeof(RgbPowerReport))
+        return false;
+
+    RgbPowerReport *_buf = (RgbPowerReport*)buf;
+
+    if ((_buf->RgbPowerFlag) & 1)
+    {
+        RGB_Power.BudgetMilliamps = _buf->RgbPowerBudget;
+        RGB_Power.MilliampsPerColor = _buf->RgbPowerMilliampsPerColor;
+        RGB_Control_Power_Changed();
+    }
+
+    if ((_buf->RgbPowerFlag >> 1) & 1)
+    {
+        RGB_Control_Save_Settings_Flash();
+    }
+
+    return true;
+}
+
+int32_t RGB_Config_Get_Segment_Report(uint8_t *buf)
+{
+    RgbSegmentReport *_buf = (RgbSegmentReport*)buf;
+    const RGB_Segment_Config *seg = &RGB_Lamp_Segments[RGB_Config_Segment_Report_Offset];
+
+    _buf->RgbSegmentFlag = 0;
+    _buf->RgbSegmentId = RGB_Config_Segment_Report_Offset;
+    _buf->RgbSegmentPhyChannelId = seg->PhyChannel;
+    _buf->RgbSegmentMode = seg->Lamps.Mode;
+    _buf->RgbSegmentWidth = seg->Lamps.Width;
+    _buf->RgbSegmentStartId = seg->Lamps.Start;
+    _buf->RgbSegmentLedCount = seg->Lamps.Count;
+
+    if (RGB_Config_Segment_Report_Offset + 1 >= RGB_LAMP_SEGMENTS_COUNT)
+        RGB_Config_Segment_Report_Offset = 0;
+    else
+        RGB_Config_Segment_Report_Offset += 1;
+
+    return sizeof(RgbSegmentReport);
+}
+
+bool RGB_Config_Set_Segment_Report(const uint8_t *buf, int32_t len)
+{
+    if (len != sizeof(RgbSegmentReport))
+        return false;
+
+    RgbSegmentReport *_buf = (RgbSegmentReport*)buf;
+    if (_buf->RgbSegmentId >= RGB_LAMP_SEGMENTS_COUNT)
+        return false;
+
+    RGB_Segment_Config seg;
+    memset(&seg, 0, sizeof(seg));  // Padding is saved too, EE_Write only skips identical records
+    seg.PhyChannel = _buf->RgbSegmentPhyChannelId;
+    seg.Lamps.Start = _buf->RgbSegmentStartId;
+    seg.Lamps.Count = _buf->RgbSegmentLedCount;
+    seg.Lamps.Mode = _buf->RgbSegmentMode;
+    seg.Lamps.Width = _buf->RgbSegmentWidth;
+    if (!RGB_Control_Segment_Valid(&seg))
+        return false;
+
+    RGB_Config_Segment_Report_Offset = _buf->RgbSegmentId;
+
+    if ((_buf->RgbSegmentFlag) & 1)
+    {
+        osMutexWait(RGB_Lamp_Colors_Mutex, osWaitForever); // Segments and color sums change together
+        RGB_Lamp_Segments[RGB_Config_Segment_Report_Offset] = seg;
+        RGB_Control_Update_Power_Sums();
+        osMutexRelease(RGB_Lamp_Colors_Mutex);
+        RGB_Control_Update_Timing();
+        RGB_Control_Segments_Changed();
+    }
+
+    if ((_buf->RgbSegmentFlag >> 1) & 1)
+    {
+        RGB_Control_Save_Settings_Flash();
+    }
+
+    return true;
+}
+
+int32_t RGB_Config_Get_Layout_Report(uint8_t *buf)
+{
+    RgbLayoutReport *_buf = (RgbLayoutReport*)buf;
+    const RGB_Layout_Shape *shape = &RGB_Lamp_Layout[RGB_Config_Layout_Report_Offset];
+
+    _buf->RgbLayoutFlag = 0;
+    _buf->RgbLayoutShapeId = RGB_Config_Layout_Report_Offset;
+    _buf->RgbLayoutShape = shape->Shape;
+    _buf->RgbLayoutParam = shape->Param;
+    _buf->RgbLayoutFirstLampId = shape->FirstLamp;
+    _buf->RgbLayoutLampCount = shape->LampCount;
+    _buf->RgbLayoutOriginX = shape->Origin[0];
+    _buf->RgbLayoutOriginY = shape->Origin[1];
+    _buf->RgbLayoutOriginZ = shape->Origin[2];
+    _buf->RgbLayoutStepX = shape->Step[0];
+    _buf->RgbLayoutStepY = shape->Step[1];
+
+    if (RGB_Config_Layout_Report_Offset + 1 >= RGB_LAYOUT_SHAPES_COUNT)
+        RGB_Config_Layout_Report_Offset = 0;
+    else
+        RGB_Config_Layout_Report_Offset += 1;
+
+    return sizeof(RgbLayoutReport);
+}
+
+bool RGB_Config_Set_Layout_Report(const uint8_t *buf, int32_t len)
+{
+    if (len != sizeof(RgbLayoutReport))
+        return false;
+
+    RgbLayoutReport *_buf = (RgbLayoutReport*)buf;
+    if (_buf->RgbLayoutShapeId >= RGB_LAYOUT_SHAPES_COUNT)
+        return false;
+
+    RGB_Layout_Shape shape;
+    memset(&shape, 0, sizeof(shape));   // Padding is saved too
+    shape.Shape = _buf->RgbLayoutShape;
+    shape.Param = _buf->RgbLayoutParam;
+    shape.FirstLamp = _buf->RgbLayoutFirstLampId;
+    shape.LampCount = _buf->RgbLayoutLampCount;
+    shape.Origin[0] = _buf->RgbLayoutOriginX;
+    shape.Origin[1] = _buf->RgbLayoutOriginY;
+    shape.Origin[2] = _buf->RgbLayoutOriginZ;
+    shape.Step[0] = _buf->RgbLayoutStepX;
+    shape.Step[1] = _buf->RgbLayoutStepY;
+    if (!RGB_Control_Layout_Shape_Valid(&shape))
+        return false;
+
+    RGB_Config_Layout_Report_Offset = _buf->RgbLayoutShapeId;
+
+    if ((_buf->RgbLayoutFlag) & 1)
+    {
+        RGB_Lamp_Layout[RGB_Config_Layout_Report_Offset] = shape; // Read by LampArray reports on the same thread
+    }
+
+    if ((_buf->RgbLayoutFlag >> 1) & 1)
+    {
+        RGB_Control_Save_Settings_Flash();
+    }
+
+    return true;
+}
+
+int32_t RGB_Config_Get_Phy_Channel_Format_Report(uint8_t *buf)
+{
+    RgbPhyChannelFormatReport *_buf = (RgbPhyChannelFormatReport*)buf;
+
+    _buf->RgbPhyChannelFormatFlag = 0;
+    _buf->RgbPhyChannelId = RGB_Config_Phy_Channel_Format_Report_Offset;
+    _buf->RgbPhyChannelFormat = RGB_Phy_Channel_Format[RGB_Config_Phy_Channel_Format_Report_Offset];
+
+    if (RGB_Config_Phy_Channel_Format_Report_Offset + 1 >= RGB_CONTROL_PHY_CHANNELS_COUNT)
+        RGB_Config_Phy_Channel_Format_Report_Offset = 0;
+    else
+        RGB_Config_Phy_Channel_Format_Report_Offset += 1;
+
+    return sizeof(RgbPhyChannelFormatReport);
+}
+
+bool RGB_Config_Set_Phy_Channel_Format_Report(const uint8_t *buf, int32_t len)
+{
+    if (len != sizeof(RgbPhyChannelFormatReport))
+        return false;
+
+    RgbPhyChannelFormatReport *_buf = (RgbPhyChannelFormatReport*)buf;
+    if (_buf->RgbPhyChannelId >= RGB_CONTROL_PHY_CHANNELS_COUNT)
+        return false;
+    if (_buf->RgbPhyChannelFormat >= RGB_PIXEL_FORMAT_COUNT)
+        return false;
+
+    RGB_Config_Phy_Channel_Format_Report_Offset = _buf->RgbPhyChannelId;
+
+    if ((_buf->RgbPhyChannelFormatFlag) & 1)
+    {
+        osMutexWait(RGB_Lamp_Colors_Mutex, osWaitForever); // GRBW chains keep a white sum
+        RGB_Phy_Channel_Format[RGB_Config_Phy_Channel_Format_Report_Offset] = _buf->RgbPhyChannelFormat;
+        RGB_Control_Update_Power_Sums();
+        osMutexRelease(RGB_Lamp_Colors_Mutex);
+        RGB_Control_Update_Timing();    // 32 bit formats take longer
+        RGB_Control_Segments_Changed();
+    }
+
+    if ((_buf->RgbPhyChannelFormatFlag >> 1) & 1)
+    {
+        RGB_Control_Save_Settings_Flash();
+    }
+
+    return true;
+}
@@ -1,4 +1,5 @@
 #include "ParamStorage.h"
+#include "ParamStorageKeys.h"
 
 #include "stm32f10x.h"
 #include "stm32f10x_flash.h"
@@ -231,8 +232,10 @@ static bool page_transfer_and_append(uint16_t new_key, const uint8_t *new_data,
     // 搬运策略：仅搬运你用得到的 key（避免 O(N^2)）
     // 需要时自行维护此列表
     static const uint16_t KEYS[] = {
-        /* 示例 */ 0x0100,                // 大数组
-        0x0010, 0x0011, 0x0012, 0x0013,    // 各种配置项
+        SK_FAN_CONTROL_CURVES_ARRAY, SK_FAN_CONTROL_CURVE_POINTS_ARRAY,
+        SK_RGB_CONFIG_HID_CHANNEL_MAP, SK_RGB_CONFIG_PHY_CHANNEL_MAP, SK_RGB_CONFIG_TIMING_PROFILE,
+        SK_RGB_CONFIG_PHY_CHANNEL_FORMAT, SK_RGB_CONFIG_CORRECTION,
+        SK_RGB_CONFIG_POWER, SK_RGB_CONFIG_SEGMENTS, SK_RGB_CONFIG_LAYOUT,
     };
 
     for (unsigned i = 0; i < sizeof(KEYS) / sizeof(KEYS[0]); ++i)
@@ -404,6 +407,7 @@ uint16_t EE_Read(uint16_t key, void *buf, uint16_t maxlen)
 
 /**
  * 写入一条记录（追加）。空间不足时触发页迁移并把本条一并写入。
+ * 与该 key 最新一条记录相同时不写：编程与擦页都要关中断，会阻塞 USB / DMA。
  * 返回值：成功 true / 失败 false。
  * 约束：本条记录不能超过单页数据区容量。
  */
@@ -413,6 +417,12 @@ bool EE_Write(uint16_t key, const void *data, uint16_t len)
     if (need > PAGE_SIZE - sizeof(PageHeader))
         return false; // 单条不能超过 1 页
 
+    uint32_t cur;
+    uint16_t cur_len;
+    if (find_latest_in_page(g_active_base, key, &cur, &cur_len) &&
+        cur_len == len && memcmp((const void *)cur, data, len) == 0)
+        return true; // 未变化
+
     __disable_irq();
 
     if (space_left() < need)
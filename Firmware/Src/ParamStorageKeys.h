@@ -6,5 +6,11 @@
 
 #define SK_RGB_CONFIG_HID_CHANNEL_MAP           (0x11)
 #define SK_RGB_CONFIG_PHY_CHANNEL_MAP           (0x12)
+#define SK_RGB_CONFIG_TIMING_PROFILE            (0x13)
+#define SK_RGB_CONFIG_PHY_CHANNEL_FORMAT        (0x14)
+#define SK_RGB_CONFIG_CORRECTION                (0x15)
+#define SK_RGB_CONFIG_POWER                     (0x16)
+#define SK_RGB_CONFIG_SEGMENTS                  (0x17)
+#define SK_RGB_CONFIG_LAYOUT                    (0x18)
 
 #endif
@@ -7,10 +7,23 @@ void RGB_Control_Load_Params(void)
 {
     EE_Read(SK_RGB_CONFIG_HID_CHANNEL_MAP, RGB_Hid_Channel_Lamp_Map, RGB_CONTROL_HID_CHANNELS_COUNT * 2 * sizeof(uint16_t));
     EE_Read(SK_RGB_CONFIG_PHY_CHANNEL_MAP, RGB_Phy_Channel_Lamp_Map, RGB_CONTROL_PHY_CHANNELS_COUNT * 2 * sizeof(uint16_t));
+    EE_Read(SK_RGB_CONFIG_TIMING_PROFILE, &RGB_Timing_Profile, sizeof(uint8_t));
+    EE_Read(SK_RGB_CONFIG_PHY_CHANNEL_FORMAT, RGB_Phy_Channel_Format, RGB_CONTROL_PHY_CHANNELS_COUNT * sizeof(uint8_t));
+    EE_Read(SK_RGB_CONFIG_CORRECTION, &RGB_Correction, sizeof(RGB_Correction_Settings));
+    EE_Read(SK_RGB_CONFIG_POWER, &RGB_Power, sizeof(RGB_Power_Settings));
+    EE_Read(SK_RGB_CONFIG_SEGMENTS, RGB_Lamp_Segments, RGB_LAMP_SEGMENTS_COUNT * sizeof(RGB_Segment_Config));
+    EE_Read(SK_RGB_CONFIG_LAYOUT, RGB_Lamp_Layout, RGB_LAYOUT_SHAPES_COUNT * sizeof(RGB_Layout_Shape));
 }
 
+// Every config report saves through here, EE_Write skips the keys that did not change
 void RGB_Control_Save_Params(void)
 {
     EE_Write(SK_RGB_CONFIG_HID_CHANNEL_MAP, RGB_Hid_Channel_Lamp_Map, RGB_CONTROL_HID_CHANNELS_COUNT * 2 * sizeof(uint16_t));
     EE_Write(SK_RGB_CONFIG_PHY_CHANNEL_MAP, RGB_Phy_Channel_Lamp_Map, RGB_CONTROL_PHY_CHANNELS_COUNT * 2 * sizeof(uint16_t));
+    EE_Write(SK_RGB_CONFIG_TIMING_PROFILE, &RGB_Timing_Profile, sizeof(uint8_t));
+    EE_Write(SK_RGB_CONFIG_PHY_CHANNEL_FORMAT, RGB_Phy_Channel_Format, RGB_CONTROL_PHY_CHANNELS_COUNT * sizeof(uint8_t));
+    EE_Write(SK_RGB_CONFIG_CORRECTION, &RGB_Correction, sizeof(RGB_Correction_Settings));
+    EE_Write(SK_RGB_CONFIG_POWER, &RGB_Power, sizeof(RGB_Power_Settings));
+    EE_Write(SK_RGB_CONFIG_SEGMENTS, RGB_Lamp_Segments, RGB_LAMP_SEGMENTS_COUNT * sizeof(RGB_Segment_Config));
+    EE_Write(SK_RGB_CONFIG_LAYOUT, RGB_Lamp_Layout, RGB_LAYOUT_SHAPES_COUNT * sizeof(RGB_Layout_Shape));
 }
@@ -5,81 +5,90 @@
 
 #include "RGBControl.h"
 #include "ParamStorageWarpper.h"
+#include "RGBUpdateRing.h"
 #include "stm32f10x.h"
 
 #include "cmsis_os.h"
+#include <string.h>
 
-volatile uint16_t RGB_WS2812_Buffer[RGB_WS2812_BUFFER_SIZE];
-volatile uint8_t RGB_Lamp_Colors[RGB_LAMP_TOTAL_COUNT * RGB_CHANNELS_PER_LAMP];
-
-static const uint16_t RGB_WS2812_NIBBLE_LUT[16][4] = {
-    /*0x0*/ {RGB_WS2812_T0H, RGB_WS2812_T0H, RGB_WS2812_T0H, RGB_WS2812_T0H},
-    /*0x1*/ {RGB_WS2812_T0H, RGB_WS2812_T0H, RGB_WS2812_T0H, RGB_WS2812_T1H},
-    /*0x2*/ {RGB_WS2812_T0H, RGB_WS2812_T0H, RGB_WS2812_T1H, RGB_WS2812_T0H},
-    /*0x3*/ {RGB_WS2812_T0H, RGB_WS2812_T0H, RGB_WS2812_T1H, RGB_WS2812_T1H},
-    /*0x4*/ {RGB_WS2812_T0H, RGB_WS2812_T1H, RGB_WS2812_T0H, RGB_WS2812_T0H},
-    /*0x5*/ {RGB_WS2812_T0H, RGB_WS2812_T1H, RGB_WS2812_T0H, RGB_WS2812_T1H},
-    /*0x6*/ {RGB_WS2812_T0H, RGB_WS2812_T1H, RGB_WS2812_T1H, RGB_WS2812_T0H},
-    /*0x7*/ {RGB_WS2812_T0H, RGB_WS2812_T1H, RGB_WS2812_T1H, RGB_WS2812_T1H},
-    /*0x8*/ {RGB_WS2812_T1H, RGB_WS2812_T0H, RGB_WS2812_T0H, RGB_WS2812_T0H},
-    /*0x9*/ {RGB_WS2812_T1H, RGB_WS2812_T0H, RGB_WS2812_T0H, RGB_WS2812_T1H},
-    /*0xA*/ {RGB_WS2812_T1H, RGB_WS2812_T0H, RGB_WS2812_T1H, RGB_WS2812_T0H},
-    /*0xB*/ {RGB_WS2812_T1H, RGB_WS2812_T0H, RGB_WS2812_T1H, RGB_WS2812_T1H},
-    /*0xC*/ {RGB_WS2812_T1H, RGB_WS2812_T1H, RGB_WS2812_T0H, RGB_WS2812_T0H},
-    /*0xD*/ {RGB_WS2812_T1H, RGB_WS2812_T1H, RGB_WS2812_T0H, RGB_WS2812_T1H},
-    /*0xE*/ {RGB_WS2812_T1H, RGB_WS2812_T1H, RGB_WS2812_T1H, RGB_WS2812_T0H},
-    /*0xF*/ {RGB_WS2812_T1H, RGB_WS2812_T1H, RGB_WS2812_T1H, RGB_WS2812_T1H},
-};
+volatile uint8_t RGB_Lamp_Colors[RGB_LAMP_TOTAL_COUNT * RGB_LAMP_STORAGE_BYTES];   // Back buffer, written by host
+static uint8_t RGB_Lamp_Colors_Front[RGB_LAMP_TOTAL_COUNT * RGB_LAMP_STORAGE_BYTES]; // Front buffer, only read by encoder during a frame
+
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+uint8_t RGB_Lamp_Palette[RGB_LAMP_PALETTE_SIZE][RGB_CHANNELS_PER_LAMP];    // Back palette, written by host
+static uint8_t RGB_Lamp_Palette_Front[RGB_LAMP_PALETTE_SIZE][RGB_CHANNELS_PER_LAMP]; // Front palette, only read by encoder during a frame
+static uint8_t RGB_Lamp_Palette_Changed = 0;            // Copy to the front palette with the next frame, under RGB_Lamp_Colors_Mutex
+static uint32_t RGB_Palette_Match_Color = 0xFFFFFFFF;  // Last color matched to the palette, consecutive lamps often share it
+static uint8_t RGB_Palette_Match_Index;
+#else
+static uint8_t RGB_Index_Palette[RGB_INDEX_PALETTE_SIZE][RGB_CHANNELS_PER_LAMP];  // Host palette of lamp index updates
+#endif
+
+osMutexDef(RGB_Lamp_Colors_Mutex);
+osMutexId RGB_Lamp_Colors_Mutex;
 
 uint16_t RGB_Hid_Channel_Lamp_Map[RGB_CONTROL_HID_CHANNELS_COUNT][2];
 uint16_t RGB_Phy_Channel_Lamp_Map[RGB_CONTROL_PHY_CHANNELS_COUNT][2];
+uint8_t RGB_Phy_Channel_Format[RGB_CONTROL_PHY_CHANNELS_COUNT];
+RGB_Segment_Config RGB_Lamp_Segments[RGB_LAMP_SEGMENTS_COUNT];
 
-osMessageQDef(RGB_Update_Msg_Queue, 4, uint8_t); // Define message queue
-osMessageQId RGB_Update_Msg_Queue;
+/* Lamp runs of all chains, the phy map entries followed by the extra segments */
+#define RGB_LAMP_RUNS_COUNT         (RGB_CONTROL_PHY_CHANNELS_COUNT + RGB_LAMP_SEGMENTS_COUNT)
 
-/* Data send status */
-static int RGB_Lamps_To_Update[RGB_CONTROL_PHY_CHANNELS_COUNT];
-static int RGB_Lamps_Encoded[RGB_CONTROL_PHY_CHANNELS_COUNT];      // LEDs in send buffer
-static int RGB_Encoded_Reset_Bits[RGB_CONTROL_PHY_CHANNELS_COUNT]; // Encoded reset bit count
-static int RGB_Update_Busy = 0;                                    // <- only need 1 because all channels updates at the same time
+/* Segments of each chain as sent, rebuilt by the RGB thread from the phy map and RGB_Lamp_Segments */
+static RGB_Lamp_Segment RGB_Chain_Segments[RGB_CONTROL_PHY_CHANNELS_COUNT][1 + RGB_LAMP_SEGMENTS_COUNT];
+static uint8_t RGB_Chain_Segment_Count[RGB_CONTROL_PHY_CHANNELS_COUNT];
+static uint16_t RGB_Chain_Lamps[RGB_CONTROL_PHY_CHANNELS_COUNT];
+static volatile uint8_t RGB_Segments_Changed = 1;
 
-static int RGB_Autonomous_Mode = 1;
+/* Lamps from the start of each phy channel changed since last frame, RGB thread only */
+static uint16_t RGB_Phy_Channel_Dirty_Lamps[RGB_CONTROL_PHY_CHANNELS_COUNT];
 
-static void RGB_Control_Encode_RGB(uint8_t r, uint8_t g, uint8_t b, volatile uint16_t *dst, uint8_t channel_id, uint8_t channel_cnt);
-static void RGB_Control_Show_RGB_Blocking_From_Array(void);
+/* Frame completion, signaled by DMA interrupts */
+#define RGB_SIGNAL_FRAME_SENT       0x01    // TIM1 / GPIO output stopped
+#define RGB_SIGNAL_SPI_FRAME_SENT   0x02    // SPI output stopped
+#define RGB_SIGNAL_COMMIT           0x04    // Host committed a frame
+#define RGB_FRAME_TIMEOUT_MS        100     // Longer than any frame, 256 lamps take ~9ms
+#define RGB_FRAME_MAX_RETRIES       2       // Resends of a frame hit by a DMA underrun
+#define RGB_PARALLEL_RESET_HOLD_MS  2       // Lines held LOW after a GPIO_PARALLEL frame
 
-static inline void RGB_Control_Encode_LUT(uint8_t v, volatile uint16_t *dst, uint8_t channel_id, uint8_t channel_cnt)
-{
-    const uint16_t *hi = RGB_WS2812_NIBBLE_LUT[v >> 4];
-    const uint16_t *lo = RGB_WS2812_NIBBLE_LUT[v & 0x0F];
+#if RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+#define RGB_WS2812_DMA_CHANNEL      DMA1_Channel2   // Channel reading RGB_WS2812_Buffer
+#else
+#define RGB_WS2812_DMA_CHANNEL      DMA1_Channel5
+#endif
 
-    // avoid volatile + memcpy warnings
-    dst[0 * channel_cnt + channel_id] = hi[0];
-    dst[1 * channel_cnt + channel_id] = hi[1];
-    dst[2 * channel_cnt + channel_id] = hi[2];
-    dst[3 * channel_cnt + channel_id] = hi[3];
-    dst[4 * channel_cnt + channel_id] = lo[0];
-    dst[5 * channel_cnt + channel_id] = lo[1];
-    dst[6 * channel_cnt + channel_id] = lo[2];
-    dst[7 * channel_cnt + channel_id] = lo[3];
-}
+volatile RGB_Control_Stats RGB_Frame_Stats;
+static volatile uint8_t RGB_Frame_Underrun;    // Set by DMA interrupts, cleared at frame start
 
-static void RGB_Control_Encode_RGB(uint8_t r, uint8_t g, uint8_t b, volatile uint16_t *dst24, uint8_t channel_id, uint8_t channel_cnt)
-{
-    RGB_Control_Encode_LUT(g, &dst24[0 * channel_cnt + channel_id], channel_id, channel_cnt);  // G
-    RGB_Control_Encode_LUT(r, &dst24[8 * channel_cnt + channel_id], channel_id, channel_cnt);  // R
-    RGB_Control_Encode_LUT(b, &dst24[16 * channel_cnt + channel_id], channel_id, channel_cnt); // B
-}
+static osThreadId RGB_Control_Thread_Id;
 
-static inline uint16_t RGB_Phy_Channel_Get_Lamp_Paddings(uint8_t channel)
-{
-    if (channel >= RGB_CONTROL_PHY_CHANNELS_COUNT)
-        return 0;
+uint8_t RGB_Timing_Profile = RGB_WS2812_TIMING_WS2812B;
+static uint8_t RGB_Timing_Profile_Applied = 0xFF;  // Profile in TIM1 and the encoder, RGB thread only
 
-    return RGB_Phy_Channel_Lamp_Map[channel][0];
-}
+RGB_Correction_Settings RGB_Correction;
+static volatile uint8_t RGB_Correction_Changed = 1; // Rebuild encoder LUT before next frame
 
-void RGB_Control_Initialize(void)
+RGB_Power_Settings RGB_Power;
+
+/*
+    Sum of each color over the lamps of each phy channel, written under RGB_Lamp_Colors_Mutex.
+    Lamps sent on several chains are lit on each of them and count once per chain.
+    GRBW chains also sum the white part min(R, G, B) in RGB_POWER_SUM_WHITE.
+*/
+#define RGB_POWER_SUM_WHITE         RGB_CHANNELS_PER_LAMP
+static uint32_t RGB_Power_Color_Sums[RGB_CONTROL_PHY_CHANNELS_COUNT][RGB_CHANNELS_PER_LAMP + 1];
+static volatile uint16_t RGB_Power_Scale = 256;    // Applied by the encoder, RGB thread only writes
+
+/* Derived from the longest chain of the phy map, see RGB_Control_Update_Timing */
+static volatile uint32_t RGB_Update_Latency;
+static volatile uint32_t RGB_Min_Update_Interval;
+
+static int RGB_Autonomous_Mode = 1;
+
+static void RGB_Control_Show_RGB_Blocking_From_Array(void);
+
+static void RGB_Control_Default_Hid_Channel_Map(void)
 {
     RGB_Hid_Channel_Lamp_Map[0][0] = 0;
     RGB_Hid_Channel_Lamp_Map[0][1] = 128;
@@ -87,76 +96,703 @@ void RGB_Control_Initialize(void)
     RGB_Hid_Channel_Lamp_Map[1][1] = 64;
     RGB_Hid_Channel_Lamp_Map[2][0] = 192;
     RGB_Hid_Channel_Lamp_Map[2][1] = 64;
+}
+
+void RGB_Control_Initialize(void)
+{
+    RGB_Lamp_Colors_Mutex = osMutexCreate(osMutex(RGB_Lamp_Colors_Mutex)); // Before USB starts writing
+
+    RGB_Control_Default_Hid_Channel_Map();
 
+#if RGB_CONTROL_PHY_CHANNELS_COUNT == 3
     RGB_Phy_Channel_Lamp_Map[0][0] = 0;
     RGB_Phy_Channel_Lamp_Map[0][1] = 128;
     RGB_Phy_Channel_Lamp_Map[1][0] = 128;
     RGB_Phy_Channel_Lamp_Map[1][1] = 128;
     RGB_Phy_Channel_Lamp_Map[2][0] = 0;
     RGB_Phy_Channel_Lamp_Map[2][1] = 256;
+#else
+    // Split lamps evenly into short parallel chains
+    for (int i = 0; i < RGB_CONTROL_PHY_CHANNELS_COUNT; i++)
+    {
+        RGB_Phy_Channel_Lamp_Map[i][0] = RGB_LAMP_TOTAL_COUNT * i / RGB_CONTROL_PHY_CHANNELS_COUNT;
+        RGB_Phy_Channel_Lamp_Map[i][1] = RGB_LAMP_TOTAL_COUNT * (i + 1) / RGB_CONTROL_PHY_CHANNELS_COUNT - RGB_Phy_Channel_Lamp_Map[i][0];
+    }
+#endif
+
+    RGB_Correction.Gamma = RGB_CORRECTION_GAMMA_LINEAR;
+    RGB_Correction.Brightness = 255;
+    RGB_Correction.Dither = 0;
+    RGB_Power.BudgetMilliamps = 0;
+    RGB_Power.MilliampsPerColor = RGB_POWER_MA_PER_COLOR;
+    for (int i = 0; i < RGB_LAMP_SEGMENTS_COUNT; i++)
+        RGB_Lamp_Segments[i].PhyChannel = RGB_SEGMENT_UNUSED;
+    for (int i = 0; i < RGB_LAYOUT_SHAPES_COUNT; i++)
+        RGB_Lamp_Layout[i].Shape = RGB_LAYOUT_NONE;
+    for (int i = 0; i < RGB_CONTROL_PHY_CHANNELS_COUNT; i++)
+    {
+        RGB_Phy_Channel_Format[i] = RGB_PIXEL_FORMAT_GRB;
+        RGB_Correction.Gain[i][0] = RGB_Correction.Gain[i][1] = RGB_Correction.Gain[i][2] = 255;
+    }
+
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+    for (int i = 0; i < RGB_LAMP_PALETTE_SIZE; i++)
+    {
+#if RGB_LAMP_PALETTE_SIZE == 256
+        // RGB332 cube
+        RGB_Lamp_Palette[i][0] = (i >> 5) * 255 / 7;
+        RGB_Lamp_Palette[i][1] = ((i >> 2) & 7) * 255 / 7;
+        RGB_Lamp_Palette[i][2] = (i & 3) * 255 / 3;
+#else
+        // Corners of the RGB cube at half and full level
+        uint8_t level = (i & 8) ? 255 : 128;
+        RGB_Lamp_Palette[i][0] = (i & 1) ? level : 0;
+        RGB_Lamp_Palette[i][1] = (i & 2) ? level : 0;
+        RGB_Lamp_Palette[i][2] = (i & 4) ? level : 0;
+#endif
+    }
+    memcpy(RGB_Lamp_Palette_Front, RGB_Lamp_Palette, sizeof(RGB_Lamp_Palette_Front));
+    RGB_Encoder_Set_Palette((const uint8_t (*)[RGB_CHANNELS_PER_LAMP])RGB_Lamp_Palette_Front);
+#endif
 
     RGB_Control_Load_Params();
+    if (!RGB_Control_Hid_Channel_Map_Valid((const uint16_t (*)[2])RGB_Hid_Channel_Lamp_Map))
+        RGB_Control_Default_Hid_Channel_Map();
+    for (int i = 0; i < RGB_CONTROL_PHY_CHANNELS_COUNT; i++)
+    {
+        if (RGB_Phy_Channel_Format[i] >= RGB_PIXEL_FORMAT_COUNT)
+            RGB_Phy_Channel_Format[i] = RGB_PIXEL_FORMAT_GRB;
+        if (RGB_Phy_Channel_Lamp_Map[i][0] > RGB_LAMP_TOTAL_COUNT)
+            RGB_Phy_Channel_Lamp_Map[i][0] = RGB_LAMP_TOTAL_COUNT;
+        if (RGB_Phy_Channel_Lamp_Map[i][1] > RGB_LAMP_TOTAL_COUNT - RGB_Phy_Channel_Lamp_Map[i][0])
+            RGB_Phy_Channel_Lamp_Map[i][1] = RGB_LAMP_TOTAL_COUNT - RGB_Phy_Channel_Lamp_Map[i][0];
+    }
+    for (int i = 0; i < RGB_LAMP_SEGMENTS_COUNT; i++)
+    {
+        if (!RGB_Control_Segment_Valid(&RGB_Lamp_Segments[i]))
+            RGB_Lamp_Segments[i].PhyChannel = RGB_SEGMENT_UNUSED;
+    }
+    for (int i = 0; i < RGB_LAYOUT_SHAPES_COUNT; i++)
+    {
+        if (!RGB_Control_Layout_Shape_Valid(&RGB_Lamp_Layout[i]))
+            RGB_Lamp_Layout[i].Shape = RGB_LAYOUT_NONE;
+    }
+    if (RGB_Timing_Profile >= RGB_WS2812_TIMING_PROFILE_COUNT)
+        RGB_Timing_Profile = RGB_WS2812_TIMING_WS2812B;
+    if (RGB_Correction.Gamma == 0)
+        RGB_Correction.Gamma = RGB_CORRECTION_GAMMA_LINEAR;
+    if (RGB_Correction.Dither > 1)
+        RGB_Correction.Dither = 0;
+    RGB_Control_Update_Timing();
+    RGB_Control_Update_Power_Sums(); // No other threads yet
+    RGB_Control_Mark_All_Dirty();
 }
 
-void RGB_Control_Save_Settings_Flash(void)
+bool RGB_Control_Hid_Channel_Map_Valid(const uint16_t map[][2])
 {
-    RGB_Control_Save_Params();
+    for (int i = 0; i < RGB_CONTROL_HID_CHANNELS_COUNT; i++)
+    {
+        if (map[i][0] + map[i][1] > RGB_LAMP_TOTAL_COUNT)
+            return false;
+
+        // Instances own their lamps, a shared lamp would take colors from two hosts
+        for (int j = 0; j < i; j++)
+        {
+            if (map[i][1] && map[j][1] && map[i][0] < map[j][0] + map[j][1] && map[j][0] < map[i][0] + map[i][1])
+                return false;
+        }
+    }
+    return true;
+}
+
+bool RGB_Control_Segment_Valid(const RGB_Segment_Config *seg)
+{
+    if (seg->PhyChannel == RGB_SEGMENT_UNUSED)
+        return true;
+    if (seg->PhyChannel >= RGB_CONTROL_PHY_CHANNELS_COUNT || seg->Lamps.Mode >= RGB_SEGMENT_MODE_COUNT)
+        return false;
+    if (seg->Lamps.Start + seg->Lamps.Count > RGB_LAMP_TOTAL_COUNT)
+        return false;
+    if (seg->Lamps.Mode == RGB_SEGMENT_SERPENTINE && (seg->Lamps.Width == 0 || seg->Lamps.Count % seg->Lamps.Width))
+        return false;
+    return true;
+}
+
+/* Run i of RGB_LAMP_RUNS_COUNT, returns its phy channel or -1 if unused */
+static int RGB_Control_Get_Run(int i, uint16_t *start, uint16_t *count)
+{
+    if (i < RGB_CONTROL_PHY_CHANNELS_COUNT)
+    {
+        *start = RGB_Phy_Channel_Lamp_Map[i][0];
+        *count = RGB_Phy_Channel_Lamp_Map[i][1];
+        return i;
+    }
+
+    const RGB_Segment_Config *seg = &RGB_Lamp_Segments[i - RGB_CONTROL_PHY_CHANNELS_COUNT];
+    if (seg->PhyChannel >= RGB_CONTROL_PHY_CHANNELS_COUNT)
+        return -1;
+    *start = seg->Lamps.Start;
+    *count = seg->Lamps.Count;
+    return seg->PhyChannel;
+}
+
+/* Lamps of a chain as configured */
+static uint32_t RGB_Control_Chain_Length(int ch)
+{
+    uint32_t lamps = 0;
+    uint16_t start, count;
+
+    for (int i = 0; i < RGB_LAMP_RUNS_COUNT; i++)
+    {
+        if (RGB_Control_Get_Run(i, &start, &count) == ch)
+            lamps += count;
+    }
+    return lamps;
+}
+
+void RGB_Control_Segments_Changed(void)
+{
+    RGB_Segments_Changed = 1;
+    RGB_Control_Mark_All_Dirty();
+}
+
+/* The encoder walks the chains during frames, rebuild them between frames */
+static void RGB_Control_Apply_Segments(void)
+{
+    if (!RGB_Segments_Changed)
+        return;
+
+    RGB_Segments_Changed = 0; // Before reading, a change meanwhile is applied next frame
+    osMutexWait(RGB_Lamp_Colors_Mutex, osWaitForever);
+    for (int ch = 0; ch < RGB_CONTROL_PHY_CHANNELS_COUNT; ch++)
+    {
+        RGB_Lamp_Segment *chain = RGB_Chain_Segments[ch];
+        int n = 0;
+        uint16_t lamps = 0;
+
+        chain[0].Start = RGB_Phy_Channel_Lamp_Map[ch][0];
+        chain[0].Count = RGB_Phy_Channel_Lamp_Map[ch][1];
+        chain[0].Mode = RGB_SEGMENT_FORWARD;
+        chain[0].Width = 0;
+        if (chain[0].Count > 0)
+            lamps += chain[n++].Count;
+
+        for (int i = 0; i < RGB_LAMP_SEGMENTS_COUNT; i++)
+        {
+            if (RGB_Lamp_Segments[i].PhyChannel != ch || RGB_Lamp_Segments[i].Lamps.Count == 0)
+                continue;
+            chain[n] = RGB_Lamp_Segments[i].Lamps;
+            lamps += chain[n++].Count;
+        }
+
+        RGB_Chain_Segment_Count[ch] = n;
+        RGB_Chain_Lamps[ch] = lamps;
+    }
+    osMutexRelease(RGB_Lamp_Colors_Mutex);
+}
+
+/*
+    A chain is sent as its data slots, the reset slots, then up to 2 more halves of the ping-pong buffer
+    until the interrupt after the last reset bit stops the output.
+*/
+static uint32_t RGB_Control_Chain_Time(uint32_t slots, uint32_t lamps_per_half, uint32_t bit_time_ns, uint32_t reset_bits)
+{
+    slots += (reset_bits + RGB_WS2812_BITS_PER_LED - 1) / RGB_WS2812_BITS_PER_LED + 2 * lamps_per_half;
+    return (slots * RGB_WS2812_BITS_PER_LED * bit_time_ns + 999) / 1000;
+}
+
+static uint32_t RGB_Control_Chain_Slots(int ch)
+{
+    return (RGB_Control_Chain_Length(ch) * RGB_PIXEL_FORMAT_BYTES(RGB_Phy_Channel_Format[ch]) + 2) / 3;
+}
+
+void RGB_Control_Update_Timing(void)
+{
+    const RGB_WS2812_Timing *timing = &RGB_WS2812_Timing_Profiles[RGB_Timing_Profile];
+    uint32_t longest = 0;
+    uint32_t latency;
+
+    for (int i = 0; i < RGB_CONTROL_PHY_CHANNELS_COUNT; i++)
+    {
+        if (i == RGB_SPI_PHY_CHANNEL)
+            continue;
+        if (RGB_Control_Chain_Slots(i) > longest)
+            longest = RGB_Control_Chain_Slots(i);
+    }
+    latency = RGB_Control_Chain_Time(longest, RGB_WS2812_LAMPS_PER_HALF, RGB_WS2812_BIT_TIME_NS(timing), RGB_WS2812_RESET_BITS(timing));
+
+#if RGB_SPI_PHY_CHANNEL >= 0
+    uint32_t spi_latency = RGB_Control_Chain_Time(RGB_Control_Chain_Slots(RGB_SPI_PHY_CHANNEL), RGB_SPI_LAMPS_PER_HALF, RGB_SPI_BIT_TIME_NS, RGB_WS2812_RESET_BITS(timing));
+    if (spi_latency > latency)
+        latency = spi_latency;
+#endif
+
+    RGB_Update_Latency = latency;
+#if RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+    RGB_Min_Update_Interval = latency + RGB_PARALLEL_RESET_HOLD_MS * 1000 + RGB_UPDATE_INTERVAL_MARGIN;
+#else
+    RGB_Min_Update_Interval = latency + RGB_UPDATE_INTERVAL_MARGIN;
+#endif
+}
+
+/* Takes effect at the next frame, all lamps are resent with the new timing */
+bool RGB_Control_Set_Timing_Profile(uint8_t profile)
+{
+    if (profile >= RGB_WS2812_TIMING_PROFILE_COUNT)
+        return false;
+
+    RGB_Timing_Profile = profile;
+    RGB_Control_Update_Timing();
+    RGB_Control_Post_Update(0, RGB_LAMP_TOTAL_COUNT - 1, 1);
+    return true;
+}
+
+/* Output is stopped between frames, reload TIM1 and the encoder tables if the profile changed */
+static void RGB_Control_Apply_Timing_Profile(void)
+{
+    uint8_t profile = RGB_Timing_Profile;
+    if (profile == RGB_Timing_Profile_Applied)
+        return;
+
+    const RGB_WS2812_Timing *timing = &RGB_WS2812_Timing_Profiles[profile];
+    RGB_Encoder_Set_Timing(timing);
+    TIM_SetAutoreload(TIM1, timing->Arr - 1);
+#if RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+    TIM_SetCompare1(TIM1, timing->T0H);
+    TIM_SetCompare2(TIM1, timing->T1H);
+#endif
+    RGB_Timing_Profile_Applied = profile;
+}
+
+/* Call after changing RGB_Correction. Takes effect at the next frame, all lamps are resent */
+void RGB_Control_Correction_Changed(void)
+{
+    RGB_Correction_Changed = 1;
+    RGB_Control_Post_Update(0, RGB_LAMP_TOTAL_COUNT - 1, 1);
+}
+
+static void RGB_Control_Apply_Correction(void)
+{
+    if (!RGB_Correction_Changed)
+        return;
+
+    RGB_Correction_Changed = 0; // Before reading, a change meanwhile is applied next frame
+    RGB_Encoder_Set_Correction(RGB_Correction.Gamma, RGB_Correction.Brightness, (const uint8_t (*)[RGB_CHANNELS_PER_LAMP])RGB_Correction.Gain);
+    RGB_Encoder_Set_Dither(RGB_Correction.Dither);
+}
+
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+/* Nearest palette color, 1 pass over the palette for each new color */
+static uint8_t RGB_Control_Match_Palette(const uint8_t *rgb)
+{
+    uint32_t color = rgb[0] | (rgb[1] << 8) | (rgb[2] << 16);
+    if (color == RGB_Palette_Match_Color)
+        return RGB_Palette_Match_Index;
+
+    uint32_t best_dist = 0xFFFFFFFF;
+    for (int i = 0; i < RGB_LAMP_PALETTE_SIZE && best_dist; i++)
+    {
+        int dr = rgb[0] - RGB_Lamp_Palette[i][0];
+        int dg = rgb[1] - RGB_Lamp_Palette[i][1];
+        int db = rgb[2] - RGB_Lamp_Palette[i][2];
+        uint32_t dist = dr * dr + dg * dg + db * db;
+        if (dist < best_dist)
+        {
+            best_dist = dist;
+            RGB_Palette_Match_Index = i;
+        }
+    }
+    RGB_Palette_Match_Color = color;
+    return RGB_Palette_Match_Index;
+}
+#endif
+
+/* Color of a lamp in the back buffer as stored, after rounding by compact formats */
+static void RGB_Control_Load_Lamp(uint16_t lamp, uint8_t *rgb)
+{
+    const volatile uint8_t *s = &RGB_Lamp_Colors[lamp * RGB_LAMP_STORAGE_BYTES];
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_RGB565
+    uint16_t v = s[0] | (s[1] << 8);
+    rgb[0] = RGB_565_RED(v);
+    rgb[1] = RGB_565_GREEN(v);
+    rgb[2] = RGB_565_BLUE(v);
+#elif RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+    memcpy(rgb, RGB_Lamp_Palette[s[0] & (RGB_LAMP_PALETTE_SIZE - 1)], RGB_CHANNELS_PER_LAMP);
+#else
+    rgb[0] = s[0];
+    rgb[1] = s[1];
+    rgb[2] = s[2];
+#endif
+}
+
+/* Store a lamp, rgb is replaced by the color actually stored */
+static void RGB_Control_Store_Lamp(uint16_t lamp, uint8_t *rgb)
+{
+    volatile uint8_t *s = &RGB_Lamp_Colors[lamp * RGB_LAMP_STORAGE_BYTES];
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_RGB565
+    uint16_t v = RGB_565_PACK(rgb[0], rgb[1], rgb[2]);
+    s[0] = v & 0xFF;
+    s[1] = v >> 8;
+    rgb[0] = RGB_565_RED(v);
+    rgb[1] = RGB_565_GREEN(v);
+    rgb[2] = RGB_565_BLUE(v);
+#elif RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+    s[0] = RGB_Control_Match_Palette(rgb);
+    memcpy(rgb, RGB_Lamp_Palette[s[0]], RGB_CHANNELS_PER_LAMP);
+#else
+    s[0] = rgb[0];
+    s[1] = rgb[1];
+    s[2] = rgb[2];
+#endif
+}
+
+/* Part of a lamp sent on the white LED of GRBW chains */
+static uint8_t RGB_Control_Lamp_White(const uint8_t *rgb)
+{
+    uint8_t w = rgb[0] < rgb[1] ? rgb[0] : rgb[1];
+    return w < rgb[2] ? w : rgb[2];
+}
+
+/* Move a lamp from old to rgb in the sums of every chain sending it */
+static void RGB_Control_Lamp_Power_Changed(uint16_t lamp, const uint8_t *old, const uint8_t *rgb)
+{
+    for (int i = 0; i < RGB_LAMP_RUNS_COUNT; i++)
+    {
+        uint16_t start, count;
+        int ch = RGB_Control_Get_Run(i, &start, &count);
+        if (ch < 0 || lamp < start || lamp >= start + count)
+            continue;
+        for (int c = 0; c < RGB_CHANNELS_PER_LAMP; c++)
+            RGB_Power_Color_Sums[ch][c] += rgb[c] - old[c];
+        if (RGB_Phy_Channel_Format[ch] == RGB_PIXEL_FORMAT_GRBW)
+            RGB_Power_Color_Sums[ch][RGB_POWER_SUM_WHITE] += RGB_Control_Lamp_White(rgb) - RGB_Control_Lamp_White(old);
+    }
+}
+
+void RGB_Control_Set_Lamp(uint16_t lamp, uint8_t red, uint8_t green, uint8_t blue)
+{
+    uint8_t rgb[RGB_CHANNELS_PER_LAMP] = {red, green, blue};
+    uint8_t old[RGB_CHANNELS_PER_LAMP];
+
+    RGB_Control_Load_Lamp(lamp, old);
+    RGB_Control_Store_Lamp(lamp, rgb);
+    RGB_Control_Lamp_Power_Changed(lamp, old, rgb);
+}
+
+void RGB_Control_Set_Lamp_Index(uint16_t lamp, uint8_t index)
+{
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+    uint8_t old[RGB_CHANNELS_PER_LAMP];
+
+    RGB_Control_Load_Lamp(lamp, old);
+    RGB_Lamp_Colors[lamp] = index;  // No palette match
+    RGB_Control_Lamp_Power_Changed(lamp, old, RGB_Lamp_Palette[index]);
+#else
+    RGB_Control_Set_Lamp(lamp, RGB_Index_Palette[index][0], RGB_Index_Palette[index][1], RGB_Index_Palette[index][2]);
+#endif
 }
 
-void RGB_Control_Fill_Half_Buffer(int half_idx)
+/*
+    Write host palette entries first..first+count-1. With palette storage the stored lamps change color,
+    all lamps are resent and commit shows them.
+*/
+bool RGB_Control_Set_Palette(uint16_t first, uint16_t count, const uint8_t colors[][RGB_CHANNELS_PER_LAMP], uint8_t commit)
 {
-    volatile uint16_t *dst = &RGB_WS2812_Buffer[half_idx * RGB_WS2812_BITS_PER_LED * RGB_CONTROL_PHY_CHANNELS_COUNT];
+    if (first + count > RGB_INDEX_PALETTE_SIZE)
+        return false;
+
+    // Any instance's HID class thread may be expanding indexes meanwhile
+    osMutexWait(RGB_Lamp_Colors_Mutex, osWaitForever);
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+    memcpy(RGB_Lamp_Palette[first], colors, count * RGB_CHANNELS_PER_LAMP);
+    RGB_Lamp_Palette_Changed = 1;           // The frame being sent keeps the front palette
+    RGB_Palette_Match_Color = 0xFFFFFFFF;   // Cached match may be stale
+    RGB_Control_Update_Power_Sums();
+    RGB_Control_Post_Update(0, RGB_LAMP_TOTAL_COUNT - 1, commit);
+#else
+    memcpy(RGB_Index_Palette[first], colors, count * RGB_CHANNELS_PER_LAMP);    // Only read by index updates
+#endif
+    osMutexRelease(RGB_Lamp_Colors_Mutex);
+
+    return true;
+}
+
+void RGB_Control_Update_Power_Sums(void)
+{
+    memset(RGB_Power_Color_Sums, 0, sizeof(RGB_Power_Color_Sums));
+    for (int i = 0; i < RGB_LAMP_RUNS_COUNT; i++)
+    {
+        uint16_t start, count;
+        int ch = RGB_Control_Get_Run(i, &start, &count);
+        if (ch < 0)
+            continue;
+
+        uint32_t end = start + count;
+        if (end > RGB_LAMP_TOTAL_COUNT)
+            end = RGB_LAMP_TOTAL_COUNT;
+        for (uint32_t j = start; j < end; j++)
+        {
+            uint8_t rgb[RGB_CHANNELS_PER_LAMP];
+            RGB_Control_Load_Lamp(j, rgb);
+            for (int c = 0; c < RGB_CHANNELS_PER_LAMP; c++)
+                RGB_Power_Color_Sums[ch][c] += rgb[c];
+            if (RGB_Phy_Channel_Format[ch] == RGB_PIXEL_FORMAT_GRBW)
+                RGB_Power_Color_Sums[ch][RGB_POWER_SUM_WHITE] += RGB_Control_Lamp_White(rgb);
+        }
+    }
+}
+
+/*
+    Current of the back buffer after brightness and gains. Gamma is left out, for gammas >= 1.0 this
+    overestimates dim colors, erring on the safe side. Hold RGB_Lamp_Colors_Mutex.
+    A GRBW lamp lights R - W, G - W, B - W and W, 2 W less than its RGB. The encoder takes W after the
+    gains, at least the white sum times the lowest gain, so that is subtracted twice.
+*/
+static uint32_t RGB_Control_Estimate_Current(uint32_t *idle_ma)
+{
+    uint32_t lit = 0;   // Sum of colors at full, in 1/255
+    uint32_t lamps = 0;
 
     for (int i = 0; i < RGB_CONTROL_PHY_CHANNELS_COUNT; i++)
     {
-        if (RGB_Lamps_Encoded[i] < RGB_Lamps_To_Update[i])
+        uint32_t chain_lit = 0;
+        uint8_t min_gain = 255;
+        for (int c = 0; c < RGB_CHANNELS_PER_LAMP; c++)
         {
-            const volatile uint8_t *p = &RGB_Lamp_Colors[RGB_Phy_Channel_Get_Lamp_Paddings(i) + RGB_Lamps_Encoded[i] * 3]; // RGBRGB...
-            RGB_Control_Encode_RGB(p[0], p[1], p[2], dst, i, RGB_CONTROL_PHY_CHANNELS_COUNT);                              // p[0]=R, p[1]=G, p[2]=B
-            RGB_Lamps_Encoded[i]++;
+            chain_lit += (RGB_Power_Color_Sums[i][c] * (RGB_Correction.Gain[i][c] + 1)) >> 8;
+            if (RGB_Correction.Gain[i][c] < min_gain)
+                min_gain = RGB_Correction.Gain[i][c];
         }
-        else
+        chain_lit -= 2 * ((RGB_Power_Color_Sums[i][RGB_POWER_SUM_WHITE] * (min_gain + 1)) >> 8);
+        lit += chain_lit;
+        lamps += RGB_Control_Chain_Length(i);
+    }
+    lit = lit * RGB_Correction.Brightness / 255;
+
+    *idle_ma = lamps * RGB_POWER_IDLE_UA_PER_LAMP / 1000;
+    return *idle_ma + lit * RGB_Power.MilliampsPerColor / 255;
+}
+
+/* Scale fitting the lit part of the estimate into the budget, 256 for none */
+static uint16_t RGB_Control_Power_Limit_Scale(void)
+{
+    uint32_t idle_ma;
+    uint32_t estimate = RGB_Control_Estimate_Current(&idle_ma);
+
+    if (RGB_Power.BudgetMilliamps == 0 || estimate <= RGB_Power.BudgetMilliamps)
+        return 256;
+    if (RGB_Power.BudgetMilliamps <= idle_ma)
+        return 0;
+    return (RGB_Power.BudgetMilliamps - idle_ma) * 256 / (estimate - idle_ma);
+}
+
+/* Call after changing RGB_Power. Takes effect at the next frame */
+void RGB_Control_Power_Changed(void)
+{
+    RGB_Control_Post_Update(0, RGB_LAMP_TOTAL_COUNT - 1, 1);
+}
+
+uint32_t RGB_Control_Get_Power_Estimate(void)
+{
+    uint32_t idle_ma;
+    osMutexWait(RGB_Lamp_Colors_Mutex, osWaitForever);  // Output reports update the sums from HID threads
+    uint32_t estimate = RGB_Control_Estimate_Current(&idle_ma);
+    osMutexRelease(RGB_Lamp_Colors_Mutex);
+    return estimate;
+}
+
+uint16_t RGB_Control_Get_Power_Scale(void) { return RGB_Power_Scale; }
+uint32_t RGB_Control_Get_Update_Latency(void) { return RGB_Update_Latency; }
+uint32_t RGB_Control_Get_Min_Update_Interval(void) { return RGB_Min_Update_Interval; }
+
+/* Last position in a segment sending one of the lamps first..last, -1 if none */
+static int RGB_Control_Segment_Last_Position(const RGB_Lamp_Segment *seg, uint16_t first, uint16_t last)
+{
+    uint16_t end = seg->Start + seg->Count - 1;
+    if (last < seg->Start || first > end)
+        return -1;
+    if (first < seg->Start)
+        first = seg->Start;
+    if (last > end)
+        last = end;
+
+    switch (seg->Mode)
+    {
+    case RGB_SEGMENT_REVERSE:
+        return end - first;
+    case RGB_SEGMENT_SERPENTINE:
+        return ((last - seg->Start) / seg->Width + 1) * seg->Width - 1; // End of the row holding last
+    default:
+        return last - seg->Start;
+    }
+}
+
+static void RGB_Control_Mark_Dirty(uint16_t first, uint16_t last)
+{
+    for (int i = 0; i < RGB_CONTROL_PHY_CHANNELS_COUNT; i++)
+    {
+        uint16_t offset = 0;
+        for (int s = 0; s < RGB_Chain_Segment_Count[i]; s++)
         {
-            // A full-zero bit, for reset
-            for (int i = 0; i < RGB_WS2812_BITS_PER_LED; i++)
-                dst[i] = 0;
-            RGB_Encoded_Reset_Bits[i] += RGB_WS2812_BITS_PER_LED;
+            // Lamps up to the last changed one, downstream lamps keep their latched colors
+            int pos = RGB_Control_Segment_Last_Position(&RGB_Chain_Segments[i][s], first, last);
+            if (pos >= 0 && offset + pos + 1 > RGB_Phy_Channel_Dirty_Lamps[i])
+                RGB_Phy_Channel_Dirty_Lamps[i] = offset + pos + 1;
+            offset += RGB_Chain_Segments[i][s].Count;
         }
     }
 }
 
+void RGB_Control_Post_Update(uint16_t first, uint16_t last, uint8_t commit)
+{
+    osMutexWait(RGB_Lamp_Colors_Mutex, osWaitForever); // Recursive, callers may hold it
+    RGB_Update_Ring_Post(first, last, commit);
+    osMutexRelease(RGB_Lamp_Colors_Mutex);
+
+    if (commit)
+        osSignalSet(RGB_Control_Thread_Id, RGB_SIGNAL_COMMIT);
+}
+
+bool RGB_Control_Post_Raw_Frame(const uint8_t *frame, uint16_t lamps)
+{
+    if (lamps == 0 || lamps > RGB_LAMP_TOTAL_COUNT)
+        return false;
+
+    osMutexWait(RGB_Lamp_Colors_Mutex, osWaitForever);
+    memcpy((uint8_t *)RGB_Lamp_Colors, frame, lamps * RGB_LAMP_STORAGE_BYTES);
+    RGB_Control_Update_Power_Sums();
+    RGB_Control_Post_Update(0, lamps - 1, 1);
+    osMutexRelease(RGB_Lamp_Colors_Mutex);
+
+    return true;
+}
+
+void RGB_Control_Mark_All_Dirty(void)
+{
+    RGB_Control_Post_Update(0, RGB_LAMP_TOTAL_COUNT - 1, 0);
+}
+
+/* Collapse all committed updates into the next frame. Returns 1 if any */
+static int RGB_Control_Collect_Updates(void)
+{
+    RGB_Control_Apply_Segments();
+    return RGB_Update_Ring_Collect(RGB_Control_Mark_Dirty);
+}
+
+void RGB_Control_Save_Settings_Flash(void)
+{
+    RGB_Control_Save_Params();
+}
+
 void RGB_Control_WS2812B_Reset(void)
 {
     TIM_Cmd(TIM1, DISABLE);
+#if RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+    GPIO_ResetBits(RGB_WS2812_PORT, RGB_PARALLEL_PIN_MASK);
+#else
     GPIO_ResetBits(RGB_WS2812_PORT, RGB_WS2812_PIN);
+#endif
     osDelay(1);
 }
 
-static void RGB_Control_Show_RGB_Blocking_From_Array(void)
+static void RGB_Control_Stop_Output(void)
+{
+#if RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+    TIM_Cmd(TIM1, DISABLE);
+    TIM_DMACmd(TIM1, TIM_DMA_Update | TIM_DMA_CC1 | TIM_DMA_CC2, DISABLE);
+    DMA_Cmd(DMA1_Channel2, DISABLE);
+    DMA_Cmd(DMA1_Channel3, DISABLE);
+    DMA_Cmd(DMA1_Channel5, DISABLE);
+
+    // Stopped anywhere in a trailing 0bit, pull all lines LOW
+    GPIO_ResetBits(RGB_WS2812_PORT, RGB_PARALLEL_PIN_MASK);
+#else
+    TIM_Cmd(TIM1, DISABLE);
+    TIM_DMACmd(TIM1, TIM_DMA_Update, DISABLE);
+    DMA_Cmd(DMA1_Channel5, DISABLE);
+#endif
+}
+
+#if RGB_SPI_PHY_CHANNEL >= 0
+static void RGB_Control_Stop_SPI_Output(void)
+{
+    SPI_I2S_DMACmd(SPI1, SPI_I2S_DMAReq_Tx, DISABLE);
+    DMA_Cmd(DMA1_Channel3, DISABLE);
+}
+#endif
+
+/*
+    DMA counts down from the full buffer size and reloads at the end, so it reads half 0 while the
+    counter is above the half size. A half refilled while DMA is not in the other one has been
+    partially clocked out with stale bits.
+*/
+static void RGB_Control_Check_Underrun(int half_idx, uint16_t remaining, uint16_t half_size)
 {
-    while (RGB_Update_Busy)
-    { /* Wait until last update finish */
-        osDelay(1);
+    if ((remaining > half_size) != (half_idx != 0))
+    {
+        RGB_Frame_Underrun = 1;
+        RGB_Frame_Stats.Underruns++;
     }
+}
 
-    RGB_Update_Busy = 1;
-    for (size_t ch = 0; ch < RGB_CONTROL_PHY_CHANNELS_COUNT; ch++)
+/*
+    Called from DMA half / full transfer interrupts.
+    The frame is done once all lamps and the reset slots are encoded. The half that just finished
+    then held the last reset bits, so the output stops here and the RGB thread is woken up.
+*/
+void RGB_Control_Half_Buffer_Sent(int half_idx)
+{
+    if (RGB_Encoder_Frame_Done())
     {
-        RGB_Lamps_To_Update[ch] = RGB_Phy_Channel_Lamp_Map[ch][1];
-        RGB_Lamps_Encoded[ch] = 0;
-        RGB_Encoded_Reset_Bits[ch] = 0;
+        RGB_Control_Stop_Output();
+        osSignalSet(RGB_Control_Thread_Id, RGB_SIGNAL_FRAME_SENT);
+        return;
     }
+    RGB_Encoder_Fill_Half_Buffer(half_idx);
+    RGB_Control_Check_Underrun(half_idx, DMA_GetCurrDataCounter(RGB_WS2812_DMA_CHANNEL), RGB_WS2812_HALF_BUFFER_SIZE);
+}
 
-    for (size_t i = 0; i < RGB_WS2812_BUFFER_SIZE; i++)
+#if RGB_SPI_PHY_CHANNEL >= 0
+void RGB_Control_SPI_Half_Buffer_Sent(int half_idx)
+{
+    if (RGB_Encoder_Frame_Done())
     {
-        // Send 2 empty bytes first
-        // No preloading since timing issues
-        RGB_WS2812_Buffer[i] = 0;
+        RGB_Control_Stop_SPI_Output();
+        osSignalSet(RGB_Control_Thread_Id, RGB_SIGNAL_SPI_FRAME_SENT);
+        return;
     }
+    RGB_Encoder_Fill_SPI_Half_Buffer(half_idx);
+    RGB_Control_Check_Underrun(half_idx, DMA_GetCurrDataCounter(DMA1_Channel3), RGB_SPI_HALF_BUFFER_SIZE);
+}
+#endif
+
+/* Clock out the front buffer once and wait for the DMA interrupts to stop the output */
+static void RGB_Control_Send_Frame(const uint16_t frame_lamps[])
+{
+    const RGB_Lamp_Segment *chains[RGB_CONTROL_PHY_CHANNELS_COUNT];
+    for (int i = 0; i < RGB_CONTROL_PHY_CHANNELS_COUNT; i++)
+        chains[i] = RGB_Chain_Segments[i];
+
+    RGB_Encoder_Begin_Frame(RGB_Lamp_Colors_Front, chains, frame_lamps, RGB_Phy_Channel_Format);
+    RGB_Frame_Underrun = 0;
+    osSignalClear(RGB_Control_Thread_Id, RGB_SIGNAL_FRAME_SENT | RGB_SIGNAL_SPI_FRAME_SENT);
 
     // Starting sequence
+#if RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+    DMA_ClearFlag(DMA1_FLAG_GL2 | DMA1_FLAG_GL3 | DMA1_FLAG_GL5);
+    DMA_SetCurrDataCounter(DMA1_Channel2, RGB_WS2812_BUFFER_SIZE);
+    DMA_SetCurrDataCounter(DMA1_Channel3, 1);
+    DMA_SetCurrDataCounter(DMA1_Channel5, 1);
+    TIM_SetCounter(TIM1, 0);
+
+    DMA_Cmd(DMA1_Channel2, ENABLE);
+    DMA_Cmd(DMA1_Channel3, ENABLE);
+    DMA_Cmd(DMA1_Channel5, ENABLE);
+    TIM_DMACmd(TIM1, TIM_DMA_Update | TIM_DMA_CC1 | TIM_DMA_CC2, ENABLE);
+    TIM_Cmd(TIM1, ENABLE);
+#else
     DMA_ClearFlag(DMA1_FLAG_GL5);
-    DMA_SetCurrDataCounter(DMA1_Channel5, RGB_WS2812_BITS_PER_LED * sizeof(uint16_t));
+    DMA_SetCurrDataCounter(DMA1_Channel5, RGB_WS2812_BUFFER_SIZE);
     TIM_SetCompare1(TIM1, RGB_WS2812_Buffer[0]);
     TIM_SetCounter(TIM1, 0);
     TIM_GenerateEvent(TIM1, TIM_EventSource_Update);
@@ -164,56 +800,135 @@ static void RGB_Control_Show_RGB_Blocking_From_Array(void)
     DMA_Cmd(DMA1_Channel5, ENABLE);
     TIM_DMACmd(TIM1, TIM_DMA_Update, ENABLE); // MUST use update & DMA1 CH5 or serious timing issues occurs
     TIM_Cmd(TIM1, ENABLE);
+#endif
+
+#if RGB_SPI_PHY_CHANNEL >= 0
+    DMA_ClearFlag(DMA1_FLAG_GL3);
+    DMA_SetCurrDataCounter(DMA1_Channel3, RGB_SPI_BUFFER_SIZE);
+    DMA_Cmd(DMA1_Channel3, ENABLE);
+    SPI_I2S_DMACmd(SPI1, SPI_I2S_DMAReq_Tx, ENABLE);
+
+    osEvent evt = osSignalWait(RGB_SIGNAL_FRAME_SENT | RGB_SIGNAL_SPI_FRAME_SENT, RGB_FRAME_TIMEOUT_MS);
+#else
+    osEvent evt = osSignalWait(RGB_SIGNAL_FRAME_SENT, RGB_FRAME_TIMEOUT_MS);
+#endif
+
+    if (evt.status != osEventSignal)
+    { // DMA stalled, don't leave the output running
+        RGB_Frame_Stats.Timeouts++;
+        RGB_Control_Stop_Output();
+#if RGB_SPI_PHY_CHANNEL >= 0
+        RGB_Control_Stop_SPI_Output();
+#endif
+    }
 
-    // wait until all LEDs sent (or scheduled to send) and reached reset slot
-    while (1)
+#if RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+    osDelay(RGB_PARALLEL_RESET_HOLD_MS); // Hold lines LOW for reset
+#endif
+}
+
+static void RGB_Control_Show_RGB_Blocking_From_Array(void)
+{
+    // Commit back buffer. Host writes hold the mutex, so no report is half applied
+    // Each channel only clocks out lamps up to its last changed one
+    uint16_t frame_lamps[RGB_CONTROL_PHY_CHANNELS_COUNT];
+    int total_lamps = 0;
+    for (int i = 0; i < RGB_CONTROL_PHY_CHANNELS_COUNT; i++)
     {
-        uint8_t data_remains = 0;
-        for (size_t i = 0; i < RGB_CONTROL_PHY_CHANNELS_COUNT; i++)
-        {
-            data_remains |= RGB_Lamps_Encoded[i] < RGB_Lamps_To_Update[i] || RGB_Encoded_Reset_Bits[i] < RGB_WS2812_RESET_CYCLES;
+        uint16_t lamps = RGB_Phy_Channel_Dirty_Lamps[i];
+        if (RGB_Phy_Channel_Format[i] == RGB_PIXEL_FORMAT_GRBW)
+        { // Whole slots only, padding 0bits would go into the next lamp
+            lamps = (lamps + 2) / 3 * 3;
+            if (lamps > RGB_Chain_Lamps[i])
+                lamps = RGB_Chain_Lamps[i];
         }
-        if (!data_remains)
-        {
-            break;
-        }
-        osThreadYield();
+
+        frame_lamps[i] = lamps;
+        total_lamps += lamps;
+        RGB_Phy_Channel_Dirty_Lamps[i] = 0;
     }
 
-    // Wait until the last reset bit sent
-    uint32_t isr0 = DMA1->ISR;
-    for (;;)
-    {
-        uint32_t isr1 = DMA1->ISR;
-        if ((isr1 ^ isr0) & (DMA_ISR_HTIF5 | DMA_ISR_TCIF5))
-            break;
+    if (total_lamps == 0)
+        return; // Nothing changed
+
+#if RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+    // All pins are clocked until the longest channel is done, a short dirty prefix would send 0bits into live lamps
+    for (int i = 0; i < RGB_CONTROL_PHY_CHANNELS_COUNT; i++)
+        frame_lamps[i] = RGB_Chain_Lamps[i];
+#endif
+
+    RGB_Control_Apply_Timing_Profile();
+    RGB_Control_Apply_Correction();
+
+    osMutexWait(RGB_Lamp_Colors_Mutex, osWaitForever);
+    memcpy(RGB_Lamp_Colors_Front, (const uint8_t *)RGB_Lamp_Colors, sizeof(RGB_Lamp_Colors_Front));
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+    if (RGB_Lamp_Palette_Changed)
+    { // Indexes and colors of the frame come from the same palette
+        memcpy(RGB_Lamp_Palette_Front, RGB_Lamp_Palette, sizeof(RGB_Lamp_Palette_Front));
+        RGB_Lamp_Palette_Changed = 0;
+    }
+#endif
+    uint16_t scale = RGB_Control_Power_Limit_Scale(); // Sums match the copied frame
+    osMutexRelease(RGB_Lamp_Colors_Mutex);
+
+    if (scale != RGB_Power_Scale)
+    { // Lamps not resent would keep the old scale
+        for (int i = 0; i < RGB_CONTROL_PHY_CHANNELS_COUNT; i++)
+            frame_lamps[i] = RGB_Chain_Lamps[i];
+        RGB_Encoder_Set_Power_Scale(scale);
+        RGB_Power_Scale = scale;
     }
 
-    // Off sequence
-    TIM_Cmd(TIM1, DISABLE);
-    TIM_DMACmd(TIM1, TIM_DMA_Update, DISABLE);
-    DMA_Cmd(DMA1_Channel5, DISABLE);
+    for (int attempt = 0; ; attempt++)
+    {
+        RGB_Control_Send_Frame(frame_lamps);
 
-    RGB_Update_Busy = 0;
+        if (!RGB_Frame_Underrun || attempt >= RGB_FRAME_MAX_RETRIES)
+            break;
+        RGB_Frame_Stats.Retries++; // Strip latched stale bits, resend the same frame. The reset bits at the end already latched it
+    }
+    RGB_Frame_Stats.Frames++;
 }
 
 void RGB_Control_thread(const void *dummy)
 {
-    osEvent evt;
+    uint32_t last_frame_tick = osKernelSysTick() - osKernelSysTickMicroSec(RGB_Control_Get_Min_Update_Interval());
 
-    RGB_Update_Msg_Queue = osMessageCreate(osMessageQ(RGB_Update_Msg_Queue), NULL); // create msg queue
+    RGB_Control_Thread_Id = osThreadGetId(); // DMA interrupts and host updates signal here
+    RGB_Control_Apply_Timing_Profile();
 
     RGB_Control_WS2812B_Reset();
 
     while (1)
     {
-        evt = osMessageGet(RGB_Update_Msg_Queue, osWaitForever);
-        if (evt.status == osEventMessage)
+        // Dithering refreshes at the max rate, only polls for commits
+        int dither = RGB_Correction.Dither;
+        osSignalWait(RGB_SIGNAL_COMMIT, dither ? 0 : osWaitForever);
+
+        // Rate limit, commits arriving meanwhile are collapsed into the same frame
+        uint32_t min_interval = osKernelSysTickMicroSec(RGB_Control_Get_Min_Update_Interval());
+        uint32_t elapsed = osKernelSysTick() - last_frame_tick;
+        if (elapsed < min_interval)
         {
+            osDelay((min_interval - elapsed) / osKernelSysTickMicroSec(1000) + 1);
+        }
+
+        if (RGB_Control_Collect_Updates() || dither)
+        {
+            if (dither)
+                RGB_Control_Mark_Dirty(0, RGB_LAMP_TOTAL_COUNT - 1); // Next dither frame of all lamps
+
+            last_frame_tick = osKernelSysTick();
             RGB_Control_Show_RGB_Blocking_From_Array();
         }
     }
 }
 
+void RGB_Control_Clear_Stats(void)
+{
+    memset((void *)&RGB_Frame_Stats, 0, sizeof(RGB_Frame_Stats));
+}
+
 void RGB_Control_Set_Autonomous_Mode(uint8_t channel, int autonomous_on) { RGB_Autonomous_Mode = autonomous_on; }
 uint8_t RGB_Control_get_Autonomous_Mode(uint8_t channel) { return RGB_Autonomous_Mode; }
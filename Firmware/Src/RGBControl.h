@@ -7,11 +7,17 @@
 #define _RGB_CONTROL_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "cmsis_os.h"
+#include "RGBEncoder.h"
 
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_RGB888
 #define RGB_LAMP_TOTAL_COUNT        256
+#else
+#define RGB_LAMP_TOTAL_COUNT        512     // Compact storage, see RGB_LAMP_STORAGE
+#endif
 #define RGB_LAMPARRAY_KIND          7       // 07 -> LampArrayKindChassis. Referer: Page 330, https://www.usb.org/sites/default/files/hut1_4.pdf
-#define RGB_MIN_UPDATE_INTERVAL     RGB_LAMP_TOTAL_COUNT * 36    // In Microseconds, assume 1.5us for 1bit in WS281X
+#define RGB_UPDATE_INTERVAL_MARGIN  500     // In Microseconds, thread wakeup and buffer copy on top of the frame time
 
 #define RGB_CUSTOM_LAMP_POSITIONS   0       // See RGBLampPositions.c
 
@@ -22,24 +28,67 @@
 #endif
 
 #define RGB_CONTROL_HID_CHANNELS_COUNT      3
-#define RGB_CONTROL_PHY_CHANNELS_COUNT      3
 extern uint16_t RGB_Hid_Channel_Lamp_Map[RGB_CONTROL_HID_CHANNELS_COUNT][2];    // For each channel, element 0 for lamp id offset
 extern uint16_t RGB_Phy_Channel_Lamp_Map[RGB_CONTROL_PHY_CHANNELS_COUNT][2];    // element 1 for lamp count
+extern uint8_t RGB_Phy_Channel_Format[RGB_CONTROL_PHY_CHANNELS_COUNT];          // RGB_PIXEL_FORMAT_* of each phy channel
+
+/*
+    A phy channel sends its phy map lamps, then the extra segments assigned to it in table order.
+    Reversed strips, mirrored copies and serpentine matrices are resolved by the encoder.
+*/
+#define RGB_LAMP_SEGMENTS_COUNT     8
+#define RGB_SEGMENT_UNUSED          0xFF    // PhyChannel of a free segment
 
-#define RGB_CHANNELS_PER_LAMP       3
+typedef struct
+{
+    uint8_t PhyChannel;         // Chain the segment is appended to, RGB_SEGMENT_UNUSED for none
+    RGB_Lamp_Segment Lamps;
+} RGB_Segment_Config;
+
+extern RGB_Segment_Config RGB_Lamp_Segments[RGB_LAMP_SEGMENTS_COUNT]; // Call RGB_Control_Segments_Changed after writing
 
 #define RGB_WS2812_PORT             GPIOA
 #define RGB_WS2812_PIN              GPIO_Pin_8
 
-#define RGB_WS2812_BITS_PER_LED     24
-#define RGB_WS2812_BUFFER_SIZE      RGB_WS2812_BITS_PER_LED * RGB_CONTROL_PHY_CHANNELS_COUNT * 2 // <- Ping-pong buffer, contains data of 2 lamps
-#define RGB_WS2812_ARR              90      // Autoreload value of TIM1
-#define RGB_WS2812_T0H              30		// 1/3 high for a 0bit
-#define RGB_WS2812_T1H              60		// 2/3 high for a 1bit
-#define RGB_WS2812_RESET_CYCLES     200     // 100bits LOW to reset
+extern uint8_t RGB_Timing_Profile;              // RGB_WS2812_TIMING_*, change with RGB_Control_Set_Timing_Profile
 
-extern volatile uint16_t RGB_WS2812_Buffer[];    // WS2812 buffer
-extern volatile uint8_t RGB_Lamp_Colors[RGB_LAMP_TOTAL_COUNT * RGB_CHANNELS_PER_LAMP];
+typedef struct
+{
+    uint8_t Gamma;          // In tenths, RGB_CORRECTION_GAMMA_LINEAR for none
+    uint8_t Brightness;     // Global, 255 for full
+    uint8_t Gain[RGB_CONTROL_PHY_CHANNELS_COUNT][RGB_CHANNELS_PER_LAMP];  // R, G, B of each phy channel, 255 for 1.0
+    uint8_t Dither;         // 1: temporal dither, frames are resent continuously. Last, stored settings without it keep 0
+} RGB_Correction_Settings;
+
+extern RGB_Correction_Settings RGB_Correction;  // Call RGB_Control_Correction_Changed after writing
+
+/*
+    Power limiter. The current of all chains is estimated from color sums kept by RGB_Control_Set_Lamp,
+    frames above the budget are scaled down by the encoder.
+*/
+#define RGB_POWER_IDLE_UA_PER_LAMP  1000    // Quiescent current of a dark lamp, in Microamperes
+#define RGB_POWER_MA_PER_COLOR      12      // Default current of 1 color of 1 lamp at full, WS2812B
+
+typedef struct
+{
+    uint16_t BudgetMilliamps;   // 0 for no limit
+    uint8_t MilliampsPerColor;  // 1 color of 1 lamp at full
+} RGB_Power_Settings;
+
+extern RGB_Power_Settings RGB_Power;            // Call RGB_Control_Power_Changed after writing
+
+extern volatile uint8_t RGB_Lamp_Colors[RGB_LAMP_TOTAL_COUNT * RGB_LAMP_STORAGE_BYTES]; // Back buffer in RGB_LAMP_STORAGE format, copied to front buffer at frame start
+extern osMutexId RGB_Lamp_Colors_Mutex;     // Hold while writing RGB_Lamp_Colors, recursive. Output reports write from HID class threads
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+extern uint8_t RGB_Lamp_Palette[RGB_LAMP_PALETTE_SIZE][RGB_CHANNELS_PER_LAMP];
+#define RGB_INDEX_PALETTE_SIZE      RGB_LAMP_PALETTE_SIZE   // Host palette is the storage palette, lamp indexes are stored as sent
+#else
+#define RGB_INDEX_PALETTE_SIZE      64      // Up to 256 colors of 3 bytes RAM, lamp indexes are expanded into RGB_Lamp_Colors
+#endif
+
+void RGB_Control_Set_Lamp(uint16_t lamp, uint8_t red, uint8_t green, uint8_t blue);    // Hold RGB_Lamp_Colors_Mutex
+void RGB_Control_Set_Lamp_Index(uint16_t lamp, uint8_t index);  // Index < RGB_INDEX_PALETTE_SIZE. Hold RGB_Lamp_Colors_Mutex
+bool RGB_Control_Set_Palette(uint16_t first, uint16_t count, const uint8_t colors[][RGB_CHANNELS_PER_LAMP], uint8_t commit);   // Takes RGB_Lamp_Colors_Mutex
 
 typedef __packed struct
 {
@@ -49,19 +98,77 @@ typedef __packed struct
 } LampPosition;
 
 #if RGB_CUSTOM_LAMP_POSITIONS == true
-extern const LampPosition RGB_Lamp_Positions[]; // ID count MUST match the size of RGB_LAMP_COUNT
+extern const LampPosition RGB_Lamp_Positions[]; // Indexed by lamp, lamps past its end use RGB_Lamp_Layout
 #endif
 
-extern osMessageQId RGB_Update_Msg_Queue;
+/*
+    Lamp layout, a few parametric shapes over runs of lamps evaluated on request.
+    Lamps covered by no shape are placed on a 1 mm line by the HID instance.
+*/
+#define RGB_LAYOUT_SHAPES_COUNT     8
+#define RGB_LAYOUT_UNIT_UM          100     // Origin and Step in tenths of Millimeters
+
+#define RGB_LAYOUT_NONE             0
+#define RGB_LAYOUT_LINE             1       // Lamp n at Origin + n * Step
+#define RGB_LAYOUT_GRID             2       // Rows of Param lamps along X, Step[0] between lamps, Step[1] between rows
+#define RGB_LAYOUT_RING             3       // Circle of radius Step[0] around Origin in the XY plane, first lamp at Param / 256 turn. Step[1] < 0 for clockwise
+#define RGB_LAYOUT_SHAPE_COUNT      4
+
+typedef struct
+{
+    uint8_t Shape;              // RGB_LAYOUT_*
+    uint8_t Param;
+    uint16_t FirstLamp;
+    uint16_t LampCount;
+    uint16_t Origin[3];         // X, Y, Z
+    int16_t Step[2];
+} RGB_Layout_Shape;
+
+extern RGB_Layout_Shape RGB_Lamp_Layout[RGB_LAYOUT_SHAPES_COUNT];
+
+bool RGB_Control_Layout_Shape_Valid(const RGB_Layout_Shape *shape);
+bool RGB_Control_Get_Lamp_Position(uint16_t lamp, uint32_t position[3]);    // X, Y, Z in Micrometers. False if no shape covers the lamp
 
 void RGB_Control_Initialize(void);
 void RGB_Control_Save_Settings_Flash(void);
 
 void RGB_Control_thread(const void * dummy);
 
-void RGB_Control_Fill_Half_Buffer(int half_idx);
 void RGB_Control_WS2812B_Reset(void);
 
+void RGB_Control_Half_Buffer_Sent(int half_idx);        // From DMA interrupts
+#if RGB_SPI_PHY_CHANNEL >= 0
+void RGB_Control_SPI_Half_Buffer_Sent(int half_idx);
+#endif
+
+void RGB_Control_Post_Update(uint16_t first, uint16_t last, uint8_t commit);   // Indexes of first and last changed lamp in RGB_Lamp_Colors. USB core and HID class threads
+bool RGB_Control_Post_Raw_Frame(const uint8_t *frame, uint16_t lamps);    // Copy and commit lamps 0..lamps-1 in RGB_LAMP_STORAGE format. Takes RGB_Lamp_Colors_Mutex
+void RGB_Control_Mark_All_Dirty(void);                          // Resend all lamps
+bool RGB_Control_Hid_Channel_Map_Valid(const uint16_t map[][2]);    // Lamps in range, no lamp in two channels
+bool RGB_Control_Segment_Valid(const RGB_Segment_Config *seg);  // Channel, mode and lamp range of a segment
+void RGB_Control_Segments_Changed(void);                        // After phy map or segment changes, resends all lamps. USB core thread only
+void RGB_Control_Update_Timing(void);                           // Recalculate frame timing, after phy map changes
+void RGB_Control_Update_Power_Sums(void);                       // Rescan color sums, after phy map or format changes. Hold RGB_Lamp_Colors_Mutex
+bool RGB_Control_Set_Timing_Profile(uint8_t profile);           // USB core thread only
+void RGB_Control_Correction_Changed(void);                      // USB core thread only
+void RGB_Control_Power_Changed(void);                           // USB core thread only
+uint32_t RGB_Control_Get_Power_Estimate(void);                  // In Milliamperes, current of the back buffer without limiting
+uint16_t RGB_Control_Get_Power_Scale(void);                     // Applied to the last frame, 256 for none
+uint32_t RGB_Control_Get_Update_Latency(void);                  // In Microseconds, from frame start until all lamps latched
+uint32_t RGB_Control_Get_Min_Update_Interval(void);             // In Microseconds, between frame starts
+
+typedef struct
+{
+    uint32_t Frames;        // Frames sent, retries not included
+    uint32_t Underruns;     // Half buffers refilled after DMA started reading them
+    uint32_t Retries;       // Frames resent after an underrun
+    uint32_t Timeouts;      // Frames aborted after RGB_FRAME_TIMEOUT_MS, DMA stalled
+    uint32_t StreamLost;    // Stream output report slices missed, from gaps in their sequence numbers
+} RGB_Control_Stats;
+
+extern volatile RGB_Control_Stats RGB_Frame_Stats;
+void RGB_Control_Clear_Stats(void);
+
 void RGB_Control_Set_Autonomous_Mode(uint8_t channel, int autonomous_on);
 uint8_t RGB_Control_get_Autonomous_Mode(uint8_t channel);
 
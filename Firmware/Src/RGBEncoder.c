@@ -0,0 +1,533 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "RGBEncoder.h"
+
+volatile RGB_WS2812_Value_t RGB_WS2812_Buffer[RGB_WS2812_BUFFER_SIZE] __attribute__((aligned(4))); // Aligned for paired stores
+
+const RGB_WS2812_Timing RGB_WS2812_Timing_Profiles[RGB_WS2812_TIMING_PROFILE_COUNT] = {
+    /* WS2812B */ {RGB_WS2812_ARR, RGB_WS2812_T0H, RGB_WS2812_T1H, RGB_WS2812_RESET_CYCLES},
+    /* WS2811  */ {180, 36, 86, 32},    // 0.5us / 1.2us high, 80us reset
+    /* SK6812  */ {90, 22, 43, 80},     // 0.3us / 0.6us high, 100us reset
+    /* Tight   */ {72, 22, 50, 64},     // 0.3us / 0.7us high
+};
+
+static uint16_t RGB_Reset_Bits = RGB_WS2812_RESET_CYCLES;
+
+#if RGB_WS2812_ENCODER == RGB_WS2812_ENCODER_NIBBLE_LUT
+static RGB_WS2812_Value_t RGB_WS2812_NIBBLE_LUT[16][4];    // Compare values of 4 bits, higher bit first sent. Built by RGB_Encoder_Set_Timing
+#endif
+
+#if RGB_WS2812_ENCODER == RGB_WS2812_ENCODER_WORD_LUT
+/*
+    Compare values of 2 consecutive bits on all 3 channels, as 3 little-endian pairs:
+    {CH1 b1, CH2 b1}, {CH3 b1, CH1 b0}, {CH2 b0, CH3 b0}
+    Index bit 0-1: CH1 bits, 2-3: CH2 bits, 4-5: CH3 bits, higher bit first sent.
+*/
+#define RGB_WS2812_PAIR_SHIFT               (8 * sizeof(RGB_WS2812_Value_t))
+
+static RGB_WS2812_Pair_t RGB_WS2812_PAIR_LUT[64][3];    // Built by RGB_Encoder_Set_Timing
+
+/* Clears the compare values of channels in reset. Index: bit n set if channel n has data */
+#define RGB_WS2812_MASK_HALF(active, ch)    ((((active) >> (ch)) & 1) ? (RGB_WS2812_Value_t)~0u : 0u)
+#define RGB_WS2812_MASK_PAIR(active, lo, hi) ((RGB_WS2812_Pair_t)(RGB_WS2812_MASK_HALF(active, lo) | ((RGB_WS2812_Pair_t)RGB_WS2812_MASK_HALF(active, hi) << RGB_WS2812_PAIR_SHIFT)))
+#define RGB_WS2812_MASK_ENTRY(active)       {RGB_WS2812_MASK_PAIR(active, 0, 1), RGB_WS2812_MASK_PAIR(active, 2, 0), RGB_WS2812_MASK_PAIR(active, 1, 2)}
+
+static const RGB_WS2812_Pair_t RGB_WS2812_ACTIVE_MASK[8][3] = {
+    RGB_WS2812_MASK_ENTRY(0), RGB_WS2812_MASK_ENTRY(1), RGB_WS2812_MASK_ENTRY(2), RGB_WS2812_MASK_ENTRY(3),
+    RGB_WS2812_MASK_ENTRY(4), RGB_WS2812_MASK_ENTRY(5), RGB_WS2812_MASK_ENTRY(6), RGB_WS2812_MASK_ENTRY(7),
+};
+#endif
+
+#if RGB_SPI_PHY_CHANNEL >= 0
+volatile uint8_t RGB_SPI_Buffer[RGB_SPI_BUFFER_SIZE];
+
+/* 4 WS2812 bits -> 12 SPI bits */
+#define RGB_SPI_SYMBOL(v, n)                ((((v) >> (n)) & 1) ? RGB_SPI_T1_SYMBOL : RGB_SPI_T0_SYMBOL)
+#define RGB_SPI_NIBBLE(v)                   ((RGB_SPI_SYMBOL(v, 3) << 9) | (RGB_SPI_SYMBOL(v, 2) << 6) | (RGB_SPI_SYMBOL(v, 1) << 3) | RGB_SPI_SYMBOL(v, 0))
+
+static const uint16_t RGB_SPI_NIBBLE_LUT[16] = {
+    RGB_SPI_NIBBLE(0x0), RGB_SPI_NIBBLE(0x1), RGB_SPI_NIBBLE(0x2), RGB_SPI_NIBBLE(0x3),
+    RGB_SPI_NIBBLE(0x4), RGB_SPI_NIBBLE(0x5), RGB_SPI_NIBBLE(0x6), RGB_SPI_NIBBLE(0x7),
+    RGB_SPI_NIBBLE(0x8), RGB_SPI_NIBBLE(0x9), RGB_SPI_NIBBLE(0xA), RGB_SPI_NIBBLE(0xB),
+    RGB_SPI_NIBBLE(0xC), RGB_SPI_NIBBLE(0xD), RGB_SPI_NIBBLE(0xE), RGB_SPI_NIBBLE(0xF),
+};
+#endif
+
+/* Data send status */
+static const volatile uint8_t *RGB_Lamp_Source;    // Framebuffer
+static const RGB_Lamp_Segment *RGB_Chain_Segment[RGB_CONTROL_PHY_CHANNELS_COUNT];  // Segment of the next lamp
+static uint16_t RGB_Chain_Position[RGB_CONTROL_PHY_CHANNELS_COUNT];                // Next lamp in that segment
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+static const uint8_t (*RGB_Lamp_Palette)[RGB_CHANNELS_PER_LAMP];
+#endif
+static int RGB_Lamps_To_Update[RGB_CONTROL_PHY_CHANNELS_COUNT];
+static int RGB_Lamps_Encoded[RGB_CONTROL_PHY_CHANNELS_COUNT];      // LEDs in send buffer
+static int RGB_Encoded_Reset_Bits[RGB_CONTROL_PHY_CHANNELS_COUNT]; // Encoded reset bit count
+static uint8_t RGB_Pixel_Carry[RGB_CONTROL_PHY_CHANNELS_COUNT][3];  // GRBW bytes for the next slot
+static uint8_t RGB_Pixel_Carry_Count[RGB_CONTROL_PHY_CHANNELS_COUNT];
+
+/* Color correction, applied while fetching lamps. Built by RGB_Encoder_Set_Correction before the first frame */
+static uint16_t RGB_Correction_LUT[256];       // Gamma and brightness, Q8.8
+static uint16_t RGB_Channel_Gain[RGB_CONTROL_PHY_CHANNELS_COUNT][RGB_CHANNELS_PER_LAMP]; // R, G, B gain + 1 times power scale, 256 for 1.0
+static uint16_t RGB_Channel_Gain_Set[RGB_CONTROL_PHY_CHANNELS_COUNT][RGB_CHANNELS_PER_LAMP]; // R, G, B gain + 1 as configured
+static uint16_t RGB_Power_Scale = 256;
+
+/*
+    Corrected values keep 8 fraction bits, an offset is added before truncating to 8 bits.
+    Temporal dither cycles the offset over 8 frames, shifted by lamp index so neighbors don't blink
+    together. Averaged over the cycle each lamp shows 3 more bits. Max 0xFF00 + 240 never overflows.
+*/
+#define RGB_DITHER_FRAMES           8
+static const uint8_t RGB_Dither_Offset_Round[RGB_DITHER_FRAMES * 2] = {128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128};
+static const uint8_t RGB_Dither_Offset_Ordered[RGB_DITHER_FRAMES * 2] = {16, 144, 80, 208, 48, 176, 112, 240, 16, 144, 80, 208, 48, 176, 112, 240};
+static const uint8_t *RGB_Dither_Offset = RGB_Dither_Offset_Round;
+static uint8_t RGB_Dither_Frame;
+
+#if RGB_WS2812_ENCODER == RGB_WS2812_ENCODER_NIBBLE_LUT
+static inline void RGB_Encoder_Encode_LUT(uint8_t v, volatile RGB_WS2812_Value_t *dst, uint8_t channel_id, uint8_t channel_cnt)
+{
+    const RGB_WS2812_Value_t *hi = RGB_WS2812_NIBBLE_LUT[v >> 4];
+    const RGB_WS2812_Value_t *lo = RGB_WS2812_NIBBLE_LUT[v & 0x0F];
+
+    // avoid volatile + memcpy warnings
+    dst[0 * channel_cnt + channel_id] = hi[0];
+    dst[1 * channel_cnt + channel_id] = hi[1];
+    dst[2 * channel_cnt + channel_id] = hi[2];
+    dst[3 * channel_cnt + channel_id] = hi[3];
+    dst[4 * channel_cnt + channel_id] = lo[0];
+    dst[5 * channel_cnt + channel_id] = lo[1];
+    dst[6 * channel_cnt + channel_id] = lo[2];
+    dst[7 * channel_cnt + channel_id] = lo[3];
+}
+#endif
+
+#if RGB_WS2812_ENCODER == RGB_WS2812_ENCODER_WORD_LUT
+#define RGB_WS2812_ENCODE_PAIR(x, shift)                                                                                 \
+    do                                                                                                                   \
+    {                                                                                                                    \
+        const RGB_WS2812_Pair_t *e = RGB_WS2812_PAIR_LUT[(((x) >> (shift)) & 0x03) | (((x) >> ((shift) + 6)) & 0x0C) | (((x) >> ((shift) + 12)) & 0x30)]; \
+        dst[0] = e[0] & m0;                                                                                              \
+        dst[1] = e[1] & m1;                                                                                              \
+        dst[2] = e[2] & m2;                                                                                              \
+        dst += 3;                                                                                                        \
+    } while (0)
+
+static void RGB_Encoder_Encode_Slot(const uint8_t grb[][RGB_CHANNELS_PER_LAMP], uint8_t active, volatile RGB_WS2812_Value_t *dst24)
+{
+    volatile RGB_WS2812_Pair_t *dst = (volatile RGB_WS2812_Pair_t *)dst24;
+    const RGB_WS2812_Pair_t m0 = RGB_WS2812_ACTIVE_MASK[active][0];
+    const RGB_WS2812_Pair_t m1 = RGB_WS2812_ACTIVE_MASK[active][1];
+    const RGB_WS2812_Pair_t m2 = RGB_WS2812_ACTIVE_MASK[active][2];
+
+    for (int i = 0; i < RGB_CHANNELS_PER_LAMP; i++)
+    {
+        uint32_t x = grb[0][i] | ((uint32_t)grb[1][i] << 8) | ((uint32_t)grb[2][i] << 16);
+        RGB_WS2812_ENCODE_PAIR(x, 6);
+        RGB_WS2812_ENCODE_PAIR(x, 4);
+        RGB_WS2812_ENCODE_PAIR(x, 2);
+        RGB_WS2812_ENCODE_PAIR(x, 0);
+    }
+}
+#elif RGB_WS2812_ENCODER == RGB_WS2812_ENCODER_NIBBLE_LUT
+static void RGB_Encoder_Encode_Reset(volatile RGB_WS2812_Value_t *dst24, uint8_t channel_id, uint8_t channel_cnt)
+{
+    // A full-zero lamp slot keeps the line LOW for reset
+    for (int bit = 0; bit < RGB_WS2812_BITS_PER_LED; bit++)
+        dst24[bit * channel_cnt + channel_id] = 0;
+}
+
+static void RGB_Encoder_Encode_Slot(const uint8_t grb[][RGB_CHANNELS_PER_LAMP], uint8_t active, volatile RGB_WS2812_Value_t *dst24)
+{
+    for (int i = 0; i < RGB_CONTROL_PHY_CHANNELS_COUNT; i++)
+    {
+        if ((active >> i) & 1)
+        {
+            RGB_Encoder_Encode_LUT(grb[i][0], &dst24[0 * RGB_CONTROL_PHY_CHANNELS_COUNT], i, RGB_CONTROL_PHY_CHANNELS_COUNT);  // G
+            RGB_Encoder_Encode_LUT(grb[i][1], &dst24[8 * RGB_CONTROL_PHY_CHANNELS_COUNT], i, RGB_CONTROL_PHY_CHANNELS_COUNT);  // R
+            RGB_Encoder_Encode_LUT(grb[i][2], &dst24[16 * RGB_CONTROL_PHY_CHANNELS_COUNT], i, RGB_CONTROL_PHY_CHANNELS_COUNT); // B
+        }
+        else
+        {
+            RGB_Encoder_Encode_Reset(dst24, i, RGB_CONTROL_PHY_CHANNELS_COUNT);
+        }
+    }
+}
+#elif RGB_WS2812_ENCODER == RGB_WS2812_ENCODER_BITSLICE
+/*
+    8x8 bit transpose (Hacker's Delight 7-3). In: 8 channel bytes, channel 7 in the MSB of x.
+    Out: 8 bit-time bytes, MSB first sent in the MSB of x, channel n in bit n of each byte.
+*/
+static inline void RGB_Encoder_Transpose8(uint32_t *px, uint32_t *py)
+{
+    uint32_t x = *px, y = *py, t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;
+    y = y ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC;
+    y = y ^ t ^ (t << 14);
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+
+    *px = t;
+    *py = y;
+}
+
+static void RGB_Encoder_Encode_Slot(const uint8_t grb[][RGB_CHANNELS_PER_LAMP], uint8_t active, volatile RGB_WS2812_Value_t *dst24)
+{
+    (void)active; // Done channels are all zero, they send 0bits
+
+    for (int i = 0; i < RGB_CHANNELS_PER_LAMP; i++)
+    {
+        uint32_t words[8] = {0};
+
+        for (int g = 0; g < RGB_CONTROL_PHY_CHANNELS_COUNT; g += 8)
+        {
+            uint8_t rows[8] = {0};
+            for (int ch = g; ch < g + 8 && ch < RGB_CONTROL_PHY_CHANNELS_COUNT; ch++)
+                rows[ch - g] = grb[ch][i];
+
+            uint32_t x = ((uint32_t)rows[7] << 24) | ((uint32_t)rows[6] << 16) | ((uint32_t)rows[5] << 8) | rows[4];
+            uint32_t y = ((uint32_t)rows[3] << 24) | ((uint32_t)rows[2] << 16) | ((uint32_t)rows[1] << 8) | rows[0];
+            RGB_Encoder_Transpose8(&x, &y);
+
+            for (int b = 0; b < 4; b++)
+            {
+                words[b] |= ((x >> (24 - 8 * b)) & 0xFF) << g;
+                words[b + 4] |= ((y >> (24 - 8 * b)) & 0xFF) << g;
+            }
+        }
+
+        // BRR at T0H clears the pins of 0bits
+        for (int b = 0; b < 8; b++)
+            dst24[i * 8 + b] = (~(words[b] << RGB_PARALLEL_FIRST_PIN)) & RGB_PARALLEL_PIN_MASK;
+    }
+}
+#endif
+
+/* Next lamp of a channel as corrected R, G, B */
+static inline void RGB_Encoder_Load_Lamp(int ch, uint8_t *rgb)
+{
+    int idx = RGB_Lamps_Encoded[ch]++;
+    const RGB_Lamp_Segment *seg = RGB_Chain_Segment[ch];
+    uint16_t pos = RGB_Chain_Position[ch];
+    uint16_t lamp;
+
+    if (seg->Mode == RGB_SEGMENT_REVERSE)
+        lamp = seg->Start + seg->Count - 1 - pos;
+    else if (seg->Mode == RGB_SEGMENT_SERPENTINE && ((pos / seg->Width) & 1))
+        lamp = seg->Start + (pos / seg->Width) * seg->Width * 2 + seg->Width - 1 - pos; // Mirrored within the row
+    else
+        lamp = seg->Start + pos;
+
+    if (++pos >= seg->Count)
+    {
+        pos = 0;
+        RGB_Chain_Segment[ch] = seg + 1;
+    }
+    RGB_Chain_Position[ch] = pos;
+
+    const volatile uint8_t *s = &RGB_Lamp_Source[lamp * RGB_LAMP_STORAGE_BYTES];
+    uint32_t d = RGB_Dither_Offset[RGB_Dither_Frame + (idx & (RGB_DITHER_FRAMES - 1))];
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_RGB565
+    uint16_t v = s[0] | (s[1] << 8);
+    const uint8_t p[RGB_CHANNELS_PER_LAMP] = {RGB_565_RED(v), RGB_565_GREEN(v), RGB_565_BLUE(v)};
+#elif RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+    const uint8_t *p = RGB_Lamp_Palette[s[0] & (RGB_LAMP_PALETTE_SIZE - 1)];
+#else
+    const volatile uint8_t *p = s; // RGBRGB...
+#endif
+
+    rgb[0] = (((RGB_Correction_LUT[p[0]] * RGB_Channel_Gain[ch][0]) >> 8) + d) >> 8;
+    rgb[1] = (((RGB_Correction_LUT[p[1]] * RGB_Channel_Gain[ch][1]) >> 8) + d) >> 8;
+    rgb[2] = (((RGB_Correction_LUT[p[2]] * RGB_Channel_Gain[ch][2]) >> 8) + d) >> 8;
+}
+
+/*
+    Fetch the next 3 wire bytes (1 slot) of a channel, or count a reset slot when the channel is done.
+    3 byte formats send 1 lamp per slot. GRBW sends 3 lamps in 4 slots, bytes not fitting a slot
+    are carried into the next one. A last partial slot is padded with 0bits, shifted out of the chain end.
+    Begin_Frame picks the fetch of each channel's format, the fill loop in the DMA interrupt has no format branch.
+*/
+static int RGB_Encoder_Reset_Slot(int ch, uint8_t *px)
+{
+    px[0] = px[1] = px[2] = 0;
+    RGB_Encoded_Reset_Bits[ch] += RGB_WS2812_BITS_PER_LED;
+    return 0;
+}
+
+/* i0, i1, i2: index into R, G, B of each wire byte */
+#define RGB_ENCODER_NEXT_SLOT_3(name, i0, i1, i2)                   \
+    static int name(int ch, uint8_t *px)                            \
+    {                                                               \
+        uint8_t rgb[RGB_CHANNELS_PER_LAMP];                         \
+        if (RGB_Lamps_Encoded[ch] >= RGB_Lamps_To_Update[ch])      \
+            return RGB_Encoder_Reset_Slot(ch, px);                  \
+        RGB_Encoder_Load_Lamp(ch, rgb);                             \
+        px[0] = rgb[i0];                                            \
+        px[1] = rgb[i1];                                            \
+        px[2] = rgb[i2];                                            \
+        return 1;                                                   \
+    }
+
+RGB_ENCODER_NEXT_SLOT_3(RGB_Encoder_Next_Slot_GRB, 1, 0, 2)
+RGB_ENCODER_NEXT_SLOT_3(RGB_Encoder_Next_Slot_RGB, 0, 1, 2)
+RGB_ENCODER_NEXT_SLOT_3(RGB_Encoder_Next_Slot_BRG, 2, 0, 1)
+
+static int RGB_Encoder_Next_Slot_GRBW(int ch, uint8_t *px)
+{
+    uint8_t rgb[RGB_CHANNELS_PER_LAMP];
+    int n = 0;
+
+    for (; n < RGB_Pixel_Carry_Count[ch]; n++)
+        px[n] = RGB_Pixel_Carry[ch][n];
+    RGB_Pixel_Carry_Count[ch] = 0;
+
+    if (n < 3 && RGB_Lamps_Encoded[ch] < RGB_Lamps_To_Update[ch])
+    {
+        RGB_Encoder_Load_Lamp(ch, rgb);
+        uint8_t w = rgb[0] < rgb[1] ? rgb[0] : rgb[1];
+        if (rgb[2] < w)
+            w = rgb[2];
+        uint8_t grbw[4] = {rgb[1] - w, rgb[0] - w, rgb[2] - w, w}; // Common part of RGB goes to the white LED
+
+        int k = 0;
+        for (; n < 3; n++)
+            px[n] = grbw[k++];
+        for (; k < 4; k++)
+            RGB_Pixel_Carry[ch][RGB_Pixel_Carry_Count[ch]++] = grbw[k];
+    }
+
+    if (n == 0)
+        return RGB_Encoder_Reset_Slot(ch, px);
+    for (; n < 3; n++)
+        px[n] = 0;
+    return 1;
+}
+
+typedef int (*RGB_Encoder_Slot_Fetch)(int ch, uint8_t *px);
+
+static const RGB_Encoder_Slot_Fetch RGB_Encoder_Slot_Fetches[RGB_PIXEL_FORMAT_COUNT] = {
+    RGB_Encoder_Next_Slot_GRB,  // RGB_PIXEL_FORMAT_GRB
+    RGB_Encoder_Next_Slot_RGB,  // RGB_PIXEL_FORMAT_RGB
+    RGB_Encoder_Next_Slot_BRG,  // RGB_PIXEL_FORMAT_BRG
+    RGB_Encoder_Next_Slot_GRBW, // RGB_PIXEL_FORMAT_GRBW
+};
+
+static RGB_Encoder_Slot_Fetch RGB_Slot_Fetch[RGB_CONTROL_PHY_CHANNELS_COUNT]; // Fetch of each channel's format, fixed during a frame
+
+static inline int RGB_Encoder_Next_Slot(int ch, uint8_t *px)
+{
+    return RGB_Slot_Fetch[ch](ch, px);
+}
+
+/*
+    Fixed point log2 / exp2 for building the gamma curve without float math.
+    Log2: x in (0, 1] as Q16, returns log2(x) as Q16 (<= 0). Bitwise method, 16 squarings.
+    Exp2: y <= 0 as Q16, returns 2^y as Q16. Cubic fit of 2^f on [0, 1), error < 0.01%.
+*/
+static int32_t RGB_Encoder_Log2(uint32_t x)
+{
+    int32_t y = 0;
+
+    while (x < 0x10000)
+    {
+        x <<= 1;
+        y -= 0x10000;
+    }
+    for (int32_t b = 0x8000; b; b >>= 1)
+    {
+        x = (uint32_t)(((uint64_t)x * x) >> 16);
+        if (x >= 0x20000)
+        {
+            x >>= 1;
+            y += b;
+        }
+    }
+    return y;
+}
+
+static uint32_t RGB_Encoder_Exp2(int32_t y)
+{
+    int32_t n = -((-y + 0xFFFF) >> 16);     // Integer part, rounded down
+    uint32_t f = (uint32_t)(y - n * 0x10000); // Fraction in [0, 1)
+
+    if (n <= -17)
+        return 0;
+
+    // 2^f ~= 1 + f * (0.6951 + f * (0.2262 + f * 0.0787))
+    uint32_t v = 0x10000 + ((f * ((45554 + ((f * ((14824 + ((f * 5158) >> 16)))) >> 16)))) >> 16);
+    return v >> -n;
+}
+
+void RGB_Encoder_Set_Correction(uint8_t gamma, uint8_t brightness, const uint8_t gains[][RGB_CHANNELS_PER_LAMP])
+{
+    for (int x = 0; x < 256; x++)
+    {
+        uint32_t t = ((uint32_t)x * 0x10000 + 127) / 255;  // x / 255 as Q16
+        if (x > 0 && gamma != RGB_CORRECTION_GAMMA_LINEAR)
+            t = RGB_Encoder_Exp2(RGB_Encoder_Log2(t) * gamma / RGB_CORRECTION_GAMMA_LINEAR);
+
+        RGB_Correction_LUT[x] = (uint16_t)((t * brightness * 256 + 0x8000) >> 16);
+    }
+
+    for (int ch = 0; ch < RGB_CONTROL_PHY_CHANNELS_COUNT; ch++)
+    {
+        for (int i = 0; i < RGB_CHANNELS_PER_LAMP; i++)
+            RGB_Channel_Gain_Set[ch][i] = gains[ch][i] + 1;
+    }
+    RGB_Encoder_Set_Power_Scale(RGB_Power_Scale);
+}
+
+/* Folded into the channel gains, so limiting costs nothing per byte */
+void RGB_Encoder_Set_Power_Scale(uint16_t scale)
+{
+    RGB_Power_Scale = scale;
+    for (int ch = 0; ch < RGB_CONTROL_PHY_CHANNELS_COUNT; ch++)
+    {
+        for (int i = 0; i < RGB_CHANNELS_PER_LAMP; i++)
+            RGB_Channel_Gain[ch][i] = (RGB_Channel_Gain_Set[ch][i] * scale) >> 8;
+    }
+}
+
+void RGB_Encoder_Set_Timing(const RGB_WS2812_Timing *timing)
+{
+#if RGB_WS2812_ENCODER == RGB_WS2812_ENCODER_WORD_LUT
+    for (int i = 0; i < 64; i++)
+    {
+        RGB_WS2812_Value_t v[6];
+        for (int n = 0; n < 6; n++)
+            v[n] = ((i >> n) & 1) ? timing->T1H : timing->T0H;
+
+        // {CH1 b1, CH2 b1}, {CH3 b1, CH1 b0}, {CH2 b0, CH3 b0}
+        RGB_WS2812_PAIR_LUT[i][0] = v[1] | ((RGB_WS2812_Pair_t)v[3] << RGB_WS2812_PAIR_SHIFT);
+        RGB_WS2812_PAIR_LUT[i][1] = v[5] | ((RGB_WS2812_Pair_t)v[0] << RGB_WS2812_PAIR_SHIFT);
+        RGB_WS2812_PAIR_LUT[i][2] = v[2] | ((RGB_WS2812_Pair_t)v[4] << RGB_WS2812_PAIR_SHIFT);
+    }
+#elif RGB_WS2812_ENCODER == RGB_WS2812_ENCODER_NIBBLE_LUT
+    for (int i = 0; i < 16; i++)
+    {
+        for (int n = 0; n < 4; n++)
+            RGB_WS2812_NIBBLE_LUT[i][n] = ((i >> (3 - n)) & 1) ? timing->T1H : timing->T0H;
+    }
+#endif
+    // BITSLICE: high times are TIM1 compare registers, set by the caller
+
+    RGB_Reset_Bits = RGB_WS2812_RESET_BITS(timing);
+}
+
+void RGB_Encoder_Set_Dither(int enable)
+{
+    RGB_Dither_Offset = enable ? RGB_Dither_Offset_Ordered : RGB_Dither_Offset_Round;
+}
+
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+void RGB_Encoder_Set_Palette(const uint8_t palette[][RGB_CHANNELS_PER_LAMP])
+{
+    RGB_Lamp_Palette = palette;
+}
+#endif
+
+void RGB_Encoder_Begin_Frame(const volatile uint8_t *colors, const RGB_Lamp_Segment *const chains[], const uint16_t lamps[], const uint8_t formats[])
+{
+    RGB_Lamp_Source = colors;
+    for (int ch = 0; ch < RGB_CONTROL_PHY_CHANNELS_COUNT; ch++)
+    {
+        RGB_Chain_Segment[ch] = chains[ch];
+        RGB_Chain_Position[ch] = 0;
+        RGB_Lamps_To_Update[ch] = lamps[ch];
+        RGB_Lamps_Encoded[ch] = 0;
+        RGB_Encoded_Reset_Bits[ch] = 0;
+        RGB_Slot_Fetch[ch] = RGB_Encoder_Slot_Fetches[formats[ch] < RGB_PIXEL_FORMAT_COUNT ? formats[ch] : RGB_PIXEL_FORMAT_GRB];
+        RGB_Pixel_Carry_Count[ch] = 0;
+    }
+    RGB_Dither_Frame = (RGB_Dither_Frame + 1) & (RGB_DITHER_FRAMES - 1);
+
+#if RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+    // Empty bit-times are 0bits here, preload both halves
+    RGB_Encoder_Fill_Half_Buffer(0);
+    RGB_Encoder_Fill_Half_Buffer(1);
+#else
+    for (int i = 0; i < RGB_WS2812_BUFFER_SIZE; i++)
+    {
+        // Send 2 empty halves first
+        // No preloading since timing issues
+        RGB_WS2812_Buffer[i] = 0;
+    }
+#endif
+
+#if RGB_SPI_PHY_CHANNEL >= 0
+    for (int i = 0; i < RGB_SPI_BUFFER_SIZE; i++)
+    {
+        RGB_SPI_Buffer[i] = 0;
+    }
+#endif
+}
+
+void RGB_Encoder_Fill_Half_Buffer(int half_idx)
+{
+    volatile RGB_WS2812_Value_t *dst = &RGB_WS2812_Buffer[half_idx * RGB_WS2812_HALF_BUFFER_SIZE];
+    uint8_t px[RGB_CONTROL_PHY_CHANNELS_COUNT][RGB_CHANNELS_PER_LAMP];
+
+    for (int slot = 0; slot < RGB_WS2812_LAMPS_PER_HALF; slot++, dst += RGB_WS2812_SLOT_SIZE)
+    {
+        uint8_t active = 0;
+
+        for (int i = 0; i < RGB_CONTROL_PHY_CHANNELS_COUNT; i++)
+        {
+            if (i == RGB_SPI_PHY_CHANNEL)
+            { // Sent by SPI, keep TIM1 output LOW
+                px[i][0] = px[i][1] = px[i][2] = 0;
+                continue;
+            }
+            if (RGB_Encoder_Next_Slot(i, px[i]))
+                active |= 1 << i;
+        }
+
+        RGB_Encoder_Encode_Slot(px, active, dst);
+    }
+}
+
+#if RGB_SPI_PHY_CHANNEL >= 0
+void RGB_Encoder_Fill_SPI_Half_Buffer(int half_idx)
+{
+    volatile uint8_t *dst = &RGB_SPI_Buffer[half_idx * RGB_SPI_HALF_BUFFER_SIZE];
+    uint8_t px[RGB_CHANNELS_PER_LAMP];
+
+    for (int slot = 0; slot < RGB_SPI_LAMPS_PER_HALF; slot++)
+    {
+        if (!RGB_Encoder_Next_Slot(RGB_SPI_PHY_CHANNEL, px))
+        { // Reset slot, line stays LOW
+            for (int i = 0; i < RGB_SPI_BYTES_PER_LED; i++)
+                *dst++ = 0;
+            continue;
+        }
+
+        for (int i = 0; i < RGB_CHANNELS_PER_LAMP; i++)
+        {
+            // 8 WS2812 bits -> 24 SPI bits, MSB first
+            uint32_t v = ((uint32_t)RGB_SPI_NIBBLE_LUT[px[i] >> 4] << 12) | RGB_SPI_NIBBLE_LUT[px[i] & 0x0F];
+            *dst++ = v >> 16;
+            *dst++ = v >> 8;
+            *dst++ = v;
+        }
+    }
+}
+#endif
+
+int RGB_Encoder_Frame_Done(void)
+{
+    // All LEDs sent (or scheduled to send) and reached reset slot
+    for (int i = 0; i < RGB_CONTROL_PHY_CHANNELS_COUNT; i++)
+    {
+        if (RGB_Lamps_Encoded[i] < RGB_Lamps_To_Update[i] || RGB_Pixel_Carry_Count[i] || RGB_Encoded_Reset_Bits[i] < RGB_Reset_Bits)
+            return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _RGB_ENCODER_H
+#define _RGB_ENCODER_H
+
+/*
+    WS2812 bit encoder for the TIM1 burst DMA ping-pong buffer.
+    No StdPeriph / RTOS dependencies here, so this module also compiles on a host
+    against a mocked TIM1 / DMA1_Channel5. Options wrapped in #ifndef can be set from the
+    compiler command line, Test/Makefile builds the host verifiers that way.
+*/
+
+#include <stdint.h>
+
+/*
+    Physical output backend
+    TIM1_PWM:       TIM1 CH1-3 on PA8-10. Burst DMA writes CCR1..3 on every update, 1 compare value per channel per bit.
+    GPIO_PARALLEL:  Up to 16 pins of RGB_WS2812_PORT. TIM1 drives 3 DMA channels per bit:
+                    update -> DMA1 CH5 sets all pins via BSRR, CC1 (T0H) -> DMA1 CH2 clears pins of 0bits via BRR,
+                    CC2 (T1H) -> DMA1 CH3 clears all pins. 1 bit-sliced word per bit for all channels.
+                    Channels with fewer lamps keep sending 0bits until the longest channel is done, which are
+                    shifted out of the end of their chains. Lines are reset LOW after the frame.
+*/
+#define RGB_PHY_BACKEND_TIM1_PWM        0
+#define RGB_PHY_BACKEND_GPIO_PARALLEL   1
+#ifndef RGB_PHY_BACKEND
+#define RGB_PHY_BACKEND                 RGB_PHY_BACKEND_TIM1_PWM
+#endif
+
+#if RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+#define RGB_CONTROL_PHY_CHANNELS_COUNT      3       // Up to 16 - RGB_PARALLEL_FIRST_PIN
+#define RGB_PARALLEL_FIRST_PIN      8       // Phy channel n on pin RGB_PARALLEL_FIRST_PIN + n, pins MUST NOT be used by other functions
+#define RGB_PARALLEL_PIN_MASK       (((1u << RGB_CONTROL_PHY_CHANNELS_COUNT) - 1) << RGB_PARALLEL_FIRST_PIN)
+#else
+#define RGB_CONTROL_PHY_CHANNELS_COUNT      3
+#endif
+#define RGB_CHANNELS_PER_LAMP       3
+
+#define RGB_WS2812_BITS_PER_LED     24      // Bits per buffer slot, 1 lamp of a 3 byte format
+
+/* Wire format of each phy channel. Lamps are stored as RGB */
+#define RGB_PIXEL_FORMAT_GRB        0       // WS2812B, SK6812
+#define RGB_PIXEL_FORMAT_RGB        1       // WS2811
+#define RGB_PIXEL_FORMAT_BRG        2
+#define RGB_PIXEL_FORMAT_GRBW       3       // SK6812 RGBW, 32 bits. W = min(R, G, B), subtracted from RGB
+#define RGB_PIXEL_FORMAT_COUNT      4
+#define RGB_PIXEL_FORMAT_BYTES(f)   ((f) == RGB_PIXEL_FORMAT_GRBW ? 4 : 3)
+
+/*
+    Storage format of lamps in the framebuffer, expanded to 8bit RGB while encoding.
+    Compact formats fit more lamps into RAM, see RGB_LAMP_TOTAL_COUNT.
+*/
+#define RGB_LAMP_STORAGE_RGB888     0       // 3 bytes per lamp
+#define RGB_LAMP_STORAGE_RGB565     1       // 2 bytes per lamp, little endian 5/6/5 bits
+#define RGB_LAMP_STORAGE_PALETTE    2       // 1 byte per lamp, index into a palette
+#ifndef RGB_LAMP_STORAGE
+#define RGB_LAMP_STORAGE            RGB_LAMP_STORAGE_RGB888
+#endif
+#ifndef RGB_LAMP_PALETTE_SIZE
+#define RGB_LAMP_PALETTE_SIZE       256     // 16 or 256 colors of 3 bytes, RGB_LAMP_STORAGE_PALETTE only. Double buffered, twice in RAM
+#endif
+
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_RGB565
+#define RGB_LAMP_STORAGE_BYTES      2
+#elif RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+#define RGB_LAMP_STORAGE_BYTES      1
+#if RGB_LAMP_PALETTE_SIZE != 16 && RGB_LAMP_PALETTE_SIZE != 256
+#error "RGB_LAMP_PALETTE_SIZE must be 16 or 256"
+#endif
+#else
+#define RGB_LAMP_STORAGE_BYTES      3
+#endif
+
+#define RGB_565_PACK(r, g, b)       ((((r) & 0xF8) << 8) | (((g) & 0xFC) << 3) | ((b) >> 3))
+#define RGB_565_RED(v)              ((((v) >> 8) & 0xF8) | (((v) >> 13) & 0x07))    // Low bits repeat the high bits, 31 -> 255
+#define RGB_565_GREEN(v)            ((((v) >> 3) & 0xFC) | (((v) >> 9) & 0x03))
+#define RGB_565_BLUE(v)             ((((v) << 3) & 0xF8) | (((v) >> 2) & 0x07))
+
+/*
+    Lamp segments. A phy channel sends the concatenation of its segments, each a run of framebuffer lamps
+    resolved while encoding. Several segments may share lamps for mirrored strips.
+*/
+#define RGB_SEGMENT_FORWARD         0
+#define RGB_SEGMENT_REVERSE         1       // Last lamp first
+#define RGB_SEGMENT_SERPENTINE      2       // Rows of Width lamps, every second row reversed. Count MUST be a multiple of Width
+#define RGB_SEGMENT_MODE_COUNT      3
+
+typedef struct
+{
+    uint16_t Start;         // First lamp in the framebuffer
+    uint16_t Count;         // Lamps, > 0 in chains given to the encoder
+    uint8_t Mode;           // RGB_SEGMENT_*
+    uint8_t Width;          // Row length of RGB_SEGMENT_SERPENTINE
+} RGB_Lamp_Segment;
+
+/* Color correction: out = LUT(gamma, brightness)[in] * gain of the phy channel and color */
+#define RGB_CORRECTION_GAMMA_LINEAR 10      // Gamma in tenths
+#define RGB_WS2812_LAMPS_PER_HALF   4       // Lamps per channel in each half of the ping-pong buffer. Larger -> fewer DMA interrupts, more RAM
+#if RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+#define RGB_WS2812_SLOT_SIZE        RGB_WS2812_BITS_PER_LED     // Buffer entries of 1 lamp on all channels
+#else
+#define RGB_WS2812_SLOT_SIZE        (RGB_WS2812_BITS_PER_LED * RGB_CONTROL_PHY_CHANNELS_COUNT)  // Buffer entries of 1 lamp on all channels
+#endif
+#define RGB_WS2812_HALF_BUFFER_SIZE (RGB_WS2812_SLOT_SIZE * RGB_WS2812_LAMPS_PER_HALF)
+#define RGB_WS2812_BUFFER_SIZE      (RGB_WS2812_HALF_BUFFER_SIZE * 2) // <- Ping-pong buffer, contains data of 2 * RGB_WS2812_LAMPS_PER_HALF lamps
+#define RGB_WS2812_ARR              90      // Autoreload value of TIM1, WS2812B profile. Used until the stored profile is applied
+#define RGB_WS2812_T0H              30		// 1/3 high for a 0bit
+#define RGB_WS2812_T1H              60		// 2/3 high for a 1bit
+#define RGB_WS2812_RESET_CYCLES     200     // 100bits LOW to reset
+#define RGB_WS2812_TIMER_CLOCK_MHZ  72      // TIM1 clock
+#ifndef RGB_WS2812_BYTE_BUFFER
+#define RGB_WS2812_BYTE_BUFFER      1       // 1: 8bit compare values in RAM, widened to 16bit by DMA. Halves buffer RAM, needs ARR <= 255
+#endif
+
+#if RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+#if RGB_PARALLEL_FIRST_PIN + RGB_CONTROL_PHY_CHANNELS_COUNT > 16
+#error "RGB_PARALLEL_FIRST_PIN + RGB_CONTROL_PHY_CHANNELS_COUNT exceeds 16 pins"
+#endif
+typedef uint16_t RGB_WS2812_Value_t;        // BRR word of 1 bit-time, pins of 0bits set
+#else
+#if RGB_WS2812_BYTE_BUFFER
+#if RGB_WS2812_ARR > 0xFF
+#error "RGB_WS2812_BYTE_BUFFER requires RGB_WS2812_ARR <= 255"
+#endif
+typedef uint8_t RGB_WS2812_Value_t;         // 1 compare value
+typedef uint16_t RGB_WS2812_Pair_t;         // 2 compare values, for combined stores
+#else
+typedef uint16_t RGB_WS2812_Value_t;
+typedef uint32_t RGB_WS2812_Pair_t;
+#endif
+#endif
+
+/*
+    LED timing profiles, selected at runtime. Values in TIM1 clocks, a bit-time is Arr clocks.
+    SPI backend channels keep their fixed symbol timing.
+*/
+#define RGB_WS2812_TIMING_WS2812B       0   // 1.25us bits, 250us reset
+#define RGB_WS2812_TIMING_WS2811        1   // 400kHz, 2.5us bits
+#define RGB_WS2812_TIMING_SK6812        2   // 1.25us bits, shorter high times, 100us reset
+#define RGB_WS2812_TIMING_TIGHT         3   // 1us bits, 64us reset. Minimum spec, only for chips tolerating it
+#define RGB_WS2812_TIMING_PROFILE_COUNT 4
+
+typedef struct
+{
+    uint8_t Arr;            // Bit-time, <= 255 for RGB_WS2812_BYTE_BUFFER
+    uint8_t T0H;            // High time of a 0bit
+    uint8_t T1H;            // High time of a 1bit
+    uint16_t ResetBits;     // LOW bit-times to latch
+} RGB_WS2812_Timing;
+
+extern const RGB_WS2812_Timing RGB_WS2812_Timing_Profiles[RGB_WS2812_TIMING_PROFILE_COUNT];
+
+#define RGB_WS2812_BIT_TIME_NS(t)       ((t)->Arr * 1000 / RGB_WS2812_TIMER_CLOCK_MHZ)
+
+#define RGB_WS2812_ENCODER_NIBBLE_LUT   0   // Per channel: 2 nibble lookups + 8 strided stores per color byte, 64 / 128 byte RAM LUT. Default
+#define RGB_WS2812_ENCODER_WORD_LUT     1   // All channels at once: 1 lookup + 3 paired stores per 2 bits. Needs 3 phy channels and a 384 / 768 byte RAM LUT, opt-in. Check with make -C Test bench
+#define RGB_WS2812_ENCODER_BITSLICE     2   // Per 8 channels: 1 8x8 bit transpose + 8 16bit stores per color byte. GPIO_PARALLEL only
+#ifndef RGB_WS2812_ENCODER
+#if RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+#define RGB_WS2812_ENCODER              RGB_WS2812_ENCODER_BITSLICE
+#else
+#define RGB_WS2812_ENCODER              RGB_WS2812_ENCODER_NIBBLE_LUT
+#endif
+#endif
+
+#if RGB_WS2812_ENCODER == RGB_WS2812_ENCODER_WORD_LUT && RGB_CONTROL_PHY_CHANNELS_COUNT != 3
+#error "RGB_WS2812_ENCODER_WORD_LUT requires exactly 3 physical channels"
+#endif
+
+/*
+    SPI backend: one physical channel can be sent over SPI1 MOSI (remapped to PB5) with DMA1 CH3 instead of TIM1.
+    Each WS2812 bit is a 3bit SPI symbol, 100 for 0 and 110 for 1. At 72MHz / 32 = 2.25MHz a SPI bit is 444ns,
+    so a WS2812 bit takes 1.33us and a LED 9 bytes. The TIM1 output of that channel stays LOW.
+*/
+#ifndef RGB_SPI_PHY_CHANNEL
+#define RGB_SPI_PHY_CHANNEL         -1      // Physical channel sent over SPI, -1 for none
+#endif
+#define RGB_SPI_LAMPS_PER_HALF      8       // Lamps in each half of the SPI ping-pong buffer
+#define RGB_SPI_BYTES_PER_LED       (RGB_WS2812_BITS_PER_LED * 3 / 8)
+#define RGB_SPI_HALF_BUFFER_SIZE    (RGB_SPI_BYTES_PER_LED * RGB_SPI_LAMPS_PER_HALF)
+#define RGB_SPI_BUFFER_SIZE         (RGB_SPI_HALF_BUFFER_SIZE * 2)
+#define RGB_SPI_T0_SYMBOL           0x4     // 0b100
+#define RGB_SPI_T1_SYMBOL           0x6     // 0b110
+#define RGB_SPI_BIT_TIME_NS         (3 * 32 * 1000 / RGB_WS2812_TIMER_CLOCK_MHZ)    // 3 SPI bits at 72MHz / 32
+
+#if RGB_SPI_PHY_CHANNEL >= RGB_CONTROL_PHY_CHANNELS_COUNT
+#error "RGB_SPI_PHY_CHANNEL out of range"
+#endif
+#if RGB_SPI_PHY_CHANNEL >= 0 && RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+#error "SPI backend shares DMA1 CH3 with RGB_PHY_BACKEND_GPIO_PARALLEL"
+#endif
+
+/*
+    Frame_Done is checked after each fill and the half filled then is never sent,
+    so it must only hold reset slots. Shorter profile resets are extended to a full half.
+*/
+#if RGB_SPI_PHY_CHANNEL >= 0 && RGB_SPI_LAMPS_PER_HALF > RGB_WS2812_LAMPS_PER_HALF
+#define RGB_WS2812_MIN_RESET_BITS   (RGB_SPI_LAMPS_PER_HALF * RGB_WS2812_BITS_PER_LED)
+#else
+#define RGB_WS2812_MIN_RESET_BITS   (RGB_WS2812_LAMPS_PER_HALF * RGB_WS2812_BITS_PER_LED)
+#endif
+#define RGB_WS2812_RESET_BITS(t)    ((t)->ResetBits < RGB_WS2812_MIN_RESET_BITS ? RGB_WS2812_MIN_RESET_BITS : (t)->ResetBits)  // Encoded after a frame
+
+extern volatile RGB_WS2812_Value_t RGB_WS2812_Buffer[];    // WS2812 buffer, CCR1..3 (TIM1_PWM) or BRR (GPIO_PARALLEL) of one bit-time per entry
+
+void RGB_Encoder_Set_Timing(const RGB_WS2812_Timing *timing);    // Not during a frame
+void RGB_Encoder_Set_Correction(uint8_t gamma, uint8_t brightness, const uint8_t gains[][RGB_CHANNELS_PER_LAMP]); // Not during a frame
+void RGB_Encoder_Set_Dither(int enable);                          // Temporal dither of corrected values, needs continuous frames
+void RGB_Encoder_Set_Power_Scale(uint16_t scale);                 // Scale of all outputs after correction, 256 for none. Not during a frame
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+void RGB_Encoder_Set_Palette(const uint8_t palette[][RGB_CHANNELS_PER_LAMP]);  // Read during frames
+#endif
+void RGB_Encoder_Begin_Frame(const volatile uint8_t *colors, const RGB_Lamp_Segment *const chains[], const uint16_t lamps[], const uint8_t formats[]); // lamps: sent of each chain, up to its segments' total
+void RGB_Encoder_Fill_Half_Buffer(int half_idx);
+int RGB_Encoder_Frame_Done(void);
+
+#if RGB_SPI_PHY_CHANNEL >= 0
+extern volatile uint8_t RGB_SPI_Buffer[];       // SPI symbols, MSB first
+
+void RGB_Encoder_Fill_SPI_Half_Buffer(int half_idx);
+#endif
+
+#endif
@@ -5,6 +5,8 @@
 
 #include "RGBControl.h"
 
+RGB_Layout_Shape RGB_Lamp_Layout[RGB_LAYOUT_SHAPES_COUNT];
+
 #if RGB_CUSTOM_LAMP_POSITIONS
 const LampPosition RGB_Lamp_Positions[] =
     {
@@ -26,3 +28,95 @@ const LampPosition RGB_Lamp_Positions[] =
         {15, 0, 0}, // X, Y, Z position in MILLImeters.
 };
 #endif
+
+/* First quarter of a sine wave, 64 steps, Q15 */
+static const int16_t RGB_Layout_Sine_LUT[65] = {
+    0, 804, 1608, 2410, 3212, 4011, 4808, 5602,
+    6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+    27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+    32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767,
+};
+
+/* angle in 1/65536 turns, result in Q15 */
+static int32_t RGB_Layout_Sine(uint16_t angle)
+{
+    uint16_t phase = angle & 0x3FFF;
+    if (angle & 0x4000)
+        phase = 0x4000 - phase; // Falling half of the quarter wave
+
+    int idx = phase >> 8;
+    int32_t value = RGB_Layout_Sine_LUT[idx];
+    if (idx < 64)
+        value += ((RGB_Layout_Sine_LUT[idx + 1] - value) * (phase & 0xFF)) >> 8;
+
+    return (angle & 0x8000) ? -value : value;
+}
+
+bool RGB_Control_Layout_Shape_Valid(const RGB_Layout_Shape *shape)
+{
+    if (shape->Shape == RGB_LAYOUT_NONE)
+        return true;
+    if (shape->Shape >= RGB_LAYOUT_SHAPE_COUNT)
+        return false;
+    if (shape->FirstLamp + shape->LampCount > RGB_LAMP_TOTAL_COUNT)
+        return false;
+    if (shape->Shape == RGB_LAYOUT_GRID && shape->Param == 0)
+        return false;
+    return true;
+}
+
+bool RGB_Control_Get_Lamp_Position(uint16_t lamp, uint32_t position[3])
+{
+#if RGB_CUSTOM_LAMP_POSITIONS
+    if (lamp < sizeof(RGB_Lamp_Positions) / sizeof(RGB_Lamp_Positions[0]))
+    {
+        position[0] = RGB_Lamp_Positions[lamp].PositionXInMillimeters * 1000;
+        position[1] = RGB_Lamp_Positions[lamp].PositionYInMillimeters * 1000;
+        position[2] = RGB_Lamp_Positions[lamp].PositionZInMillimeters * 1000;
+        return true;
+    }
+#endif
+
+    for (int i = 0; i < RGB_LAYOUT_SHAPES_COUNT; i++)
+    {
+        const RGB_Layout_Shape *shape = &RGB_Lamp_Layout[i];
+        if (shape->Shape == RGB_LAYOUT_NONE || lamp < shape->FirstLamp || lamp >= shape->FirstLamp + shape->LampCount)
+            continue;
+
+        int32_t n = lamp - shape->FirstLamp;
+        int32_t pos[3] = {shape->Origin[0], shape->Origin[1], shape->Origin[2]};
+
+        switch (shape->Shape)
+        {
+        case RGB_LAYOUT_LINE:
+            pos[0] += n * shape->Step[0];
+            pos[1] += n * shape->Step[1];
+            break;
+        case RGB_LAYOUT_GRID:
+            pos[0] += (n % shape->Param) * shape->Step[0];
+            pos[1] += (n / shape->Param) * shape->Step[1];
+            break;
+        case RGB_LAYOUT_RING:
+        {
+            uint16_t angle = (uint32_t)n * 65536 / shape->LampCount;
+            if (shape->Step[1] < 0)
+                angle = -angle;
+            angle += shape->Param << 8;
+            pos[0] += (shape->Step[0] * RGB_Layout_Sine(angle + 0x4000)) >> 15;
+            pos[1] += (shape->Step[0] * RGB_Layout_Sine(angle)) >> 15;
+            break;
+        }
+        }
+
+        for (int k = 0; k < 3; k++)
+            position[k] = pos[k] > 0 ? pos[k] * RGB_LAYOUT_UNIT_UM : 0; // Lamps outside the box are clamped to its edge
+        return true;
+    }
+
+    return false;
+}
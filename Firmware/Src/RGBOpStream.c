@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "RGBOpStream.h"
+
+bool RGB_Op_Stream_Decode(const uint8_t *ops, int32_t len, uint16_t start, uint16_t lamp_count,
+                          RGB_Op_Span_Sink sink, uint16_t *first, uint16_t *last)
+{
+    uint32_t lamp = start;  // 32 bits, runs of 63 cannot wrap
+    int32_t pos = 0;
+
+    *first = 0xFFFF;
+    *last = 0;
+
+    while (pos < len && ops[pos] != 0x00)
+    {
+        uint8_t op = ops[pos] & RGB_OP_MASK;
+        uint8_t count = ops[pos] & RGB_OP_COUNT_MASK;
+        pos++;
+
+        if (count == 0 || lamp + count > lamp_count)
+            return false; // Empty op or past the last lamp
+
+        int32_t payload;
+        switch (op)
+        {
+        case RGB_OP_SKIP:
+            payload = 0;
+            break;
+        case RGB_OP_RUN:
+            payload = 3;
+            break;
+        case RGB_OP_LITERAL:
+            payload = 3 * count;
+            break;
+        default:
+            return false; // Reserved
+        }
+
+        if (payload > len - pos)
+            return false; // Truncated colors
+
+        if (op != RGB_OP_SKIP)
+        {
+            if (sink)
+                sink(lamp, count, &ops[pos], op == RGB_OP_RUN ? 0 : 3);
+
+            if (lamp < *first)
+                *first = lamp;
+            *last = lamp + count - 1;
+        }
+
+        lamp += count;
+        pos += payload;
+    }
+
+    return true;
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _RGB_OP_STREAM_H
+#define _RGB_OP_STREAM_H
+
+/*
+    Run-length / delta op stream of the lamp ops report.
+    No StdPeriph / RTOS dependencies here, so the decoder also compiles on a host for fuzzing.
+
+    Each op is a header byte, bit7-6 op and bit5-0 lamp count (1..63), followed by its colors:
+        SKIP    0x00 | n    n lamps keep their color, no payload
+        RUN     0x40 | n    n lamps set to one color, 3 bytes R, G, B
+        LITERAL 0x80 | n    n lamps set to n colors, 3 * n bytes
+    A 0x00 header ends the stream, so zero padding is fine. Op 0xC0 is reserved.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RGB_OP_SKIP                 0x00
+#define RGB_OP_RUN                  0x40
+#define RGB_OP_LITERAL              0x80
+#define RGB_OP_MASK                 0xC0
+#define RGB_OP_COUNT_MASK           0x3F
+
+/* Span of lamps from lamp, colors advance by stride bytes per lamp: 0 for a run, 3 for literals */
+typedef void (*RGB_Op_Span_Sink)(uint16_t lamp, uint16_t count, const uint8_t *colors, uint8_t stride);
+
+/*
+    Decode ops into lamps start..lamp_count-1, sink NULL only validates.
+    Returns false on a reserved op, a truncated color or a lamp past lamp_count, without writing anything
+    as long as it was validated first. first / last get the written lamp range, first > last if none.
+*/
+bool RGB_Op_Stream_Decode(const uint8_t *ops, int32_t len, uint16_t start, uint16_t lamp_count,
+                          RGB_Op_Span_Sink sink, uint16_t *first, uint16_t *last);
+
+#endif
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "RGBUpdateRing.h"
+
+typedef struct
+{
+    uint16_t First;     // Index of first changed lamp, > Last if none
+    uint16_t Last;      // Index of last changed lamp
+} RGB_Update_Record;
+
+/* Free-running indexes, the head is written by producers only, the tail by the consumer only */
+static volatile RGB_Update_Record RGB_Update_Ring[RGB_UPDATE_RING_SIZE];
+static volatile uint8_t RGB_Update_Ring_Head = 0;
+static volatile uint8_t RGB_Update_Ring_Tail = 0;
+static volatile uint8_t RGB_Update_Ring_Lost = 0;   // Set by producer when full, consumer resends everything
+
+/* Not committed yet, producers only */
+static uint16_t RGB_Update_Pending_First = 0xFFFF;
+static uint16_t RGB_Update_Pending_Last = 0;
+
+void RGB_Update_Ring_Post(uint16_t first, uint16_t last, uint8_t commit)
+{
+    if (first <= last)
+    { // Widen the pending range, empty is 0xFFFF..0
+        if (first < RGB_Update_Pending_First)
+            RGB_Update_Pending_First = first;
+        if (last > RGB_Update_Pending_Last)
+            RGB_Update_Pending_Last = last;
+    }
+    if (!commit)
+        return;
+
+    uint8_t head = RGB_Update_Ring_Head;
+    if ((uint8_t)(head - RGB_Update_Ring_Tail) >= RGB_UPDATE_RING_SIZE)
+    {
+        RGB_Update_Ring_Lost = 1;
+    }
+    else
+    {
+        RGB_Update_Ring[head & (RGB_UPDATE_RING_SIZE - 1)].First = RGB_Update_Pending_First;
+        RGB_Update_Ring[head & (RGB_UPDATE_RING_SIZE - 1)].Last = RGB_Update_Pending_Last;
+        RGB_Update_Ring_Head = head + 1; // Publish after the record is written
+    }
+    RGB_Update_Pending_First = 0xFFFF;
+    RGB_Update_Pending_Last = 0;
+}
+
+int RGB_Update_Ring_Collect(RGB_Update_Ring_Sink mark)
+{
+    int commit = 0;
+
+    while (RGB_Update_Ring_Tail != RGB_Update_Ring_Head)
+    {
+        const volatile RGB_Update_Record *r = &RGB_Update_Ring[RGB_Update_Ring_Tail & (RGB_UPDATE_RING_SIZE - 1)];
+        if (r->First <= r->Last)
+            mark(r->First, r->Last);
+        commit = 1;
+        RGB_Update_Ring_Tail++;
+    }
+
+    if (RGB_Update_Ring_Lost)
+    {
+        RGB_Update_Ring_Lost = 0;
+        mark(0, RGB_UPDATE_ALL_LAMPS);
+        commit = 1;
+    }
+
+    return commit;
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _RGB_UPDATE_RING_H
+#define _RGB_UPDATE_RING_H
+
+/*
+    Host updates, several producers (USB core thread for feature reports, HID class threads for output reports)
+    and single consumer (RGB thread). No StdPeriph / RTOS dependencies here, producers are serialized by the
+    caller (RGB_Lamp_Colors_Mutex), so the ring also compiles on a host.
+
+    Updates without commit only widen a pending lamp range, a commit publishes it as one record.
+    A frame of many reports takes one record, not one per report.
+*/
+
+#include <stdint.h>
+
+#define RGB_UPDATE_RING_SIZE        16      // Commits in flight, power of 2
+#define RGB_UPDATE_ALL_LAMPS        0xFFFF  // Last lamp of a lost update, every lamp is dirty
+
+/* Changed lamp range first..last of a collected record */
+typedef void (*RGB_Update_Ring_Sink)(uint16_t first, uint16_t last);
+
+void RGB_Update_Ring_Post(uint16_t first, uint16_t last, uint8_t commit);  // first > last if no lamps. Producers, serialized
+int RGB_Update_Ring_Collect(RGB_Update_Ring_Sink mark);                     // Consumer. Returns 1 if any record committed
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "rl_usb.h"
+
+#include "RGBControl.h"
+
+/*
+    Raw frame stream, vendor interface with bulk OUT endpoint 4.
+    Each transfer is one frame: lamps from 0 in RGB_LAMP_STORAGE format.
+    A full buffer ends the transfer, a shorter frame ends with a short or zero length packet.
+    Frames land in a staging buffer and are copied into RGB_Lamp_Colors under its mutex, so no frame
+    shows partially. The host is NAKed during the copy, frames faster than the LEDs are coalesced.
+*/
+#define RGB_STREAM_EP               USB_ENDPOINT_OUT(4)
+
+static uint8_t RGB_Stream_Frame[RGB_LAMP_TOTAL_COUNT * RGB_LAMP_STORAGE_BYTES];   // Only linked in with the custom class enabled
+static volatile bool RGB_Stream_Active = false;
+
+static void RGB_Stream_Start_Read(void)
+{
+  USBD_EndpointRead(0, RGB_STREAM_EP, RGB_Stream_Frame, sizeof(RGB_Stream_Frame));
+}
+
+void USBD_CustomClass0_Initialize(void)
+{
+}
+
+void USBD_CustomClass0_Uninitialize(void)
+{
+}
+
+void USBD_CustomClass0_Reset(void)
+{
+  RGB_Stream_Active = false;
+}
+
+void USBD_CustomClass0_EndpointStart(uint8_t ep_addr)
+{
+  if (ep_addr == RGB_STREAM_EP)
+  {
+    RGB_Stream_Active = true;
+    RGB_Stream_Start_Read();
+  }
+}
+
+void USBD_CustomClass0_EndpointStop(uint8_t ep_addr)
+{
+  if (ep_addr == RGB_STREAM_EP)
+    RGB_Stream_Active = false;
+}
+
+usbdRequestStatus USBD_CustomClass0_Endpoint0_SetupPacketReceived(const USB_SETUP_PACKET *setup_packet, uint8_t **buf, uint32_t *len)
+{
+  return usbdRequestNotProcessed;
+}
+
+void USBD_CustomClass0_Endpoint0_SetupPacketProcessed(const USB_SETUP_PACKET *setup_packet)
+{
+}
+
+usbdRequestStatus USBD_CustomClass0_Endpoint0_OutDataReceived(uint32_t len)
+{
+  return usbdRequestNotProcessed;
+}
+
+usbdRequestStatus USBD_CustomClass0_Endpoint0_InDataSent(uint32_t len)
+{
+  return usbdRequestNotProcessed;
+}
+
+void USBD_CustomClass0_Endpoint4_Event(uint32_t event)
+{
+  if (!(event & ARM_USBD_EVENT_OUT))
+    return;
+
+  uint32_t len = USBD_EndpointReadGetResult(0, RGB_STREAM_EP);
+  uint16_t lamps = len / RGB_LAMP_STORAGE_BYTES;  // Partial lamp dropped
+  if (lamps)
+    RGB_Control_Post_Raw_Frame(RGB_Stream_Frame, lamps);
+
+  if (RGB_Stream_Active)
+    RGB_Stream_Start_Read();
+}
@@ -11,7 +11,7 @@
 #include "Fancontrol.h"
 
 // HID Usage Tables: 1.6.0
-// Descriptor size: 388 (bytes)
+// Descriptor size: 648 (bytes)
 // AUTO-GENERATED by WaratahCmd.exe (https://github.com/microsoft/hidtools)
 // +----------+---------+-------------------+
 // | ReportId | Kind    | ReportSizeInBytes |
@@ -34,6 +34,20 @@
 // +----------+---------+-------------------+
 // |        9 | Feature |                 6 |
 // +----------+---------+-------------------+
+// |       10 | Feature |                21 |
+// +----------+---------+-------------------+
+// |       11 | Feature |                 6 |
+// +----------+---------+-------------------+
+// |       12 | Feature |                 8 |
+// +----------+---------+-------------------+
+// |       13 | Feature |                 7 |
+// +----------+---------+-------------------+
+// |       14 | Feature |                 9 |
+// +----------+---------+-------------------+
+// |       15 | Feature |                18 |
+// +----------+---------+-------------------+
+// |       16 | Feature |                 3 |
+// +----------+---------+-------------------+
 const uint8_t usbd_hid0_report_descriptor[] =
     {
         0x06, 0x60, 0xFF,             // UsagePage(USBreezeUsagePage[0xFF60])
@@ -214,6 +228,128 @@ const uint8_t usbd_hid0_report_descriptor[] =
         0x75, 0x10,                   //         ReportSize(16)
         0xB1, 0x02,                   //         Feature(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
         0xC0,                         //     EndCollection()
+        0x85, 0x0A,                   //     ReportId(10)
+        0x09, 0xB0,                   //     UsageId(RgbStatsReport[0x00B0])
+        0xA1, 0x02,                   //     Collection(Logical)
+        0x09, 0xB1,                   //         UsageId(RgbStatsFlag[0x00B1])
+        0x26, 0xFF, 0x00,             //         LogicalMaximum(255)
+        0x95, 0x01,                   //         ReportCount(1)
+        0x75, 0x08,                   //         ReportSize(8)
+        0xB1, 0x02,                   //         Feature(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0x09, 0xB2,                   //         UsageId(RgbStatsFrames[0x00B2])
+        0x09, 0xB3,                   //         UsageId(RgbStatsUnderruns[0x00B3])
+        0x09, 0xB4,                   //         UsageId(RgbStatsRetries[0x00B4])
+        0x09, 0xB5,                   //         UsageId(RgbStatsTimeouts[0x00B5])
+        0x09, 0xB6,                   //         UsageId(RgbStatsStreamLost[0x00B6])
+        0x27, 0xFF, 0xFF, 0xFF, 0x7F, //         LogicalMaximum(2,147,483,647)
+        0x95, 0x05,                   //         ReportCount(5)
+        0x75, 0x20,                   //         ReportSize(32)
+        0xB1, 0x02,                   //         Feature(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0xC0,                         //     EndCollection()
+        0x85, 0x0B,                   //     ReportId(11)
+        0x09, 0xA0,                   //     UsageId(RgbTimingReport[0x00A0])
+        0xA1, 0x02,                   //     Collection(Logical)
+        0x09, 0xA1,                   //         UsageId(RgbTimingFlag[0x00A1])
+        0x09, 0xA2,                   //         UsageId(RgbTimingProfile[0x00A2])
+        0x26, 0xFF, 0x00,             //         LogicalMaximum(255)
+        0x95, 0x02,                   //         ReportCount(2)
+        0x75, 0x08,                   //         ReportSize(8)
+        0xB1, 0x02,                   //         Feature(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0x09, 0xA3,                   //         UsageId(RgbTimingBitTime[0x00A3])
+        0x09, 0xA4,                   //         UsageId(RgbTimingResetTime[0x00A4])
+        0x27, 0xFF, 0xFF, 0x00, 0x00, //         LogicalMaximum(65,535)
+        0x75, 0x10,                   //         ReportSize(16)
+        0xB1, 0x02,                   //         Feature(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0xC0,                         //     EndCollection()
+        0x85, 0x0C,                   //     ReportId(12)
+        0x09, 0x90,                   //     UsageId(RgbCorrectionReport[0x0090])
+        0xA1, 0x02,                   //     Collection(Logical)
+        0x09, 0x91,                   //         UsageId(RgbCorrectionFlag[0x0091])
+        0x09, 0x92,                   //         UsageId(RgbCorrectionPhyChannelId[0x0092])
+        0x09, 0x93,                   //         UsageId(RgbCorrectionGamma[0x0093])
+        0x09, 0x94,                   //         UsageId(RgbCorrectionBrightness[0x0094])
+        0x09, 0x95,                   //         UsageId(RgbCorrectionGainRed[0x0095])
+        0x09, 0x96,                   //         UsageId(RgbCorrectionGainGreen[0x0096])
+        0x09, 0x97,                   //         UsageId(RgbCorrectionGainBlue[0x0097])
+        0x09, 0x98,                   //         UsageId(RgbCorrectionDither[0x0098])
+        0x26, 0xFF, 0x00,             //         LogicalMaximum(255)
+        0x95, 0x08,                   //         ReportCount(8)
+        0x75, 0x08,                   //         ReportSize(8)
+        0xB1, 0x02,                   //         Feature(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0xC0,                         //     EndCollection()
+        0x85, 0x0D,                   //     ReportId(13)
+        0x09, 0x80,                   //     UsageId(RgbPowerReport[0x0080])
+        0xA1, 0x02,                   //     Collection(Logical)
+        0x09, 0x81,                   //         UsageId(RgbPowerFlag[0x0081])
+        0x09, 0x82,                   //         UsageId(RgbPowerMilliampsPerColor[0x0082])
+        0x09, 0x83,                   //         UsageId(RgbPowerScale[0x0083])
+        0x95, 0x03,                   //         ReportCount(3)
+        0xB1, 0x02,                   //         Feature(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0x09, 0x84,                   //         UsageId(RgbPowerBudget[0x0084])
+        0x09, 0x85,                   //         UsageId(RgbPowerEstimate[0x0085])
+        0x27, 0xFF, 0xFF, 0x00, 0x00, //         LogicalMaximum(65,535)
+        0x95, 0x02,                   //         ReportCount(2)
+        0x75, 0x10,                   //         ReportSize(16)
+        0xB1, 0x02,                   //         Feature(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0xC0,                         //     EndCollection()
+        0x85, 0x0E,                   //     ReportId(14)
+        0x09, 0x70,                   //     UsageId(RgbSegmentReport[0x0070])
+        0xA1, 0x02,                   //     Collection(Logical)
+        0x09, 0x71,                   //         UsageId(RgbSegmentFlag[0x0071])
+        0x09, 0x72,                   //         UsageId(RgbSegmentId[0x0072])
+        0x09, 0x73,                   //         UsageId(RgbSegmentPhyChannelId[0x0073])
+        0x09, 0x74,                   //         UsageId(RgbSegmentMode[0x0074])
+        0x09, 0x75,                   //         UsageId(RgbSegmentWidth[0x0075])
+        0x26, 0xFF, 0x00,             //         LogicalMaximum(255)
+        0x95, 0x05,                   //         ReportCount(5)
+        0x75, 0x08,                   //         ReportSize(8)
+        0xB1, 0x02,                   //         Feature(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0x09, 0x76,                   //         UsageId(RgbSegmentStartId[0x0076])
+        0x09, 0x77,                   //         UsageId(RgbSegmentLedCount[0x0077])
+        0x27, 0xFF, 0xFF, 0x00, 0x00, //         LogicalMaximum(65,535)
+        0x95, 0x02,                   //         ReportCount(2)
+        0x75, 0x10,                   //         ReportSize(16)
+        0xB1, 0x02,                   //         Feature(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0xC0,                         //     EndCollection()
+        0x85, 0x0F,                   //     ReportId(15)
+        0x09, 0xF0,                   //     UsageId(RgbLayoutReport[0x00F0])
+        0xA1, 0x02,                   //     Collection(Logical)
+        0x09, 0xF1,                   //         UsageId(RgbLayoutFlag[0x00F1])
+        0x09, 0xF2,                   //         UsageId(RgbLayoutShapeId[0x00F2])
+        0x09, 0xF3,                   //         UsageId(RgbLayoutShape[0x00F3])
+        0x09, 0xF4,                   //         UsageId(RgbLayoutParam[0x00F4])
+        0x26, 0xFF, 0x00,             //         LogicalMaximum(255)
+        0x95, 0x04,                   //         ReportCount(4)
+        0x75, 0x08,                   //         ReportSize(8)
+        0xB1, 0x02,                   //         Feature(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0x09, 0xF5,                   //         UsageId(RgbLayoutFirstLampId[0x00F5])
+        0x09, 0xF6,                   //         UsageId(RgbLayoutLampCount[0x00F6])
+        0x09, 0xF7,                   //         UsageId(RgbLayoutOriginX[0x00F7])
+        0x09, 0xF8,                   //         UsageId(RgbLayoutOriginY[0x00F8])
+        0x09, 0xF9,                   //         UsageId(RgbLayoutOriginZ[0x00F9])
+        0x27, 0xFF, 0xFF, 0x00, 0x00, //         LogicalMaximum(65,535)
+        0x95, 0x05,                   //         ReportCount(5)
+        0x75, 0x10,                   //         ReportSize(16)
+        0xB1, 0x02,                   //         Feature(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0x09, 0xFA,                   //         UsageId(RgbLayoutStepX[0x00FA])
+        0x09, 0xFB,                   //         UsageId(RgbLayoutStepY[0x00FB])
+        0x16, 0x00, 0x80,             //         LogicalMinimum(-32,768)
+        0x26, 0xFF, 0x7F,             //         LogicalMaximum(32,767)
+        0x95, 0x02,                   //         ReportCount(2)
+        0xB1, 0x02,                   //         Feature(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0xC0,                         //     EndCollection()
+        0x85, 0x10,                   //     ReportId(16)
+        0x09, 0xC5,                   //     UsageId(RgbPhyChannelFormatReport[0x00C5])
+        0xA1, 0x02,                   //     Collection(Logical)
+        0x09, 0xC6,                   //         UsageId(RgbPhyChannelFormatFlag[0x00C6])
+        0x09, 0xE6,                   //         UsageId(RgbPhyChannelId[0x00E6])
+        0x09, 0xC4,                   //         UsageId(RgbPhyChannelFormat[0x00C4])
+        0x15, 0x00,                   //         LogicalMinimum(0)
+        0x26, 0xFF, 0x00,             //         LogicalMaximum(255)
+        0x95, 0x03,                   //         ReportCount(3)
+        0x75, 0x08,                   //         ReportSize(8)
+        0xB1, 0x02,                   //         Feature(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0xC0,                         //     EndCollection()
         0xC0,                         // EndCollection()
 };
 
@@ -263,6 +399,20 @@ int32_t USBD_HID0_GetReport(uint8_t rtype, uint8_t req, uint8_t rid, uint8_t *bu
       return RGB_Config_Get_Hid_Channel_Map_Report(buf);
     case RGB_CONFIG_PHY_CHANNEL_MAP_REPORT_ID:
       return RGB_Config_Get_Phy_Channel_Map_Report(buf);
+    case RGB_CONFIG_STATS_REPORT_ID:
+      return RGB_Config_Get_Stats_Report(buf);
+    case RGB_CONFIG_TIMING_REPORT_ID:
+      return RGB_Config_Get_Timing_Report(buf);
+    case RGB_CONFIG_CORRECTION_REPORT_ID:
+      return RGB_Config_Get_Correction_Report(buf);
+    case RGB_CONFIG_POWER_REPORT_ID:
+      return RGB_Config_Get_Power_Report(buf);
+    case RGB_CONFIG_SEGMENT_REPORT_ID:
+      return RGB_Config_Get_Segment_Report(buf);
+    case RGB_CONFIG_LAYOUT_REPORT_ID:
+      return RGB_Config_Get_Layout_Report(buf);
+    case RGB_CONFIG_PHY_CHANNEL_FORMAT_REPORT_ID:
+      return RGB_Config_Get_Phy_Channel_Format_Report(buf);
 
     default:
       break;
@@ -316,6 +466,20 @@ bool USBD_HID0_SetReport(uint8_t rtype, uint8_t req, uint8_t rid, const uint8_t
       return RGB_Config_Set_Hid_Channel_Map_Report(buf, len);
     case RGB_CONFIG_PHY_CHANNEL_MAP_REPORT_ID:
       return RGB_Config_Set_Phy_Channel_Map_Report(buf, len);
+    case RGB_CONFIG_STATS_REPORT_ID:
+      return RGB_Config_Set_Stats_Report(buf, len);
+    case RGB_CONFIG_TIMING_REPORT_ID:
+      return RGB_Config_Set_Timing_Report(buf, len);
+    case RGB_CONFIG_CORRECTION_REPORT_ID:
+      return RGB_Config_Set_Correction_Report(buf, len);
+    case RGB_CONFIG_POWER_REPORT_ID:
+      return RGB_Config_Set_Power_Report(buf, len);
+    case RGB_CONFIG_SEGMENT_REPORT_ID:
+      return RGB_Config_Set_Segment_Report(buf, len);
+    case RGB_CONFIG_LAYOUT_REPORT_ID:
+      return RGB_Config_Set_Layout_Report(buf, len);
+    case RGB_CONFIG_PHY_CHANNEL_FORMAT_REPORT_ID:
+      return RGB_Config_Set_Phy_Channel_Format_Report(buf, len);
 
     default:
       break;
@@ -10,7 +10,7 @@
 #include "HostCommWarpper.h"
 
 // HID Usage Tables: 1.6.0
-// Descriptor size: 308 (bytes)
+// Descriptor size: 433 (bytes)
 // AUTO-GENERATED by WaratahCmd.exe (https://github.com/microsoft/hidtools)
 // +----------+---------+-------------------+
 // | ReportId | Kind    | ReportSizeInBytes |
@@ -27,6 +27,14 @@
 // +----------+---------+-------------------+
 // |        6 | Feature |                 1 |
 // +----------+---------+-------------------+
+// |        7 | Output  |                63 |
+// +----------+---------+-------------------+
+// |        8 | Output  |                63 |
+// +----------+---------+-------------------+
+// |        9 | Output  |                62 |
+// +----------+---------+-------------------+
+// |       10 | Output  |                63 |
+// +----------+---------+-------------------+
 const uint8_t usbd_hid1_report_descriptor[] =
     {
         0x05, 0x59,                   // UsagePage(Lighting And Illumination[0x0059])
@@ -176,6 +184,66 @@ const uint8_t usbd_hid1_report_descriptor[] =
         0xB1, 0x02,                   //         Feature(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
         0xC0,                         //     EndCollection()
         0xC0,                         // EndCollection()
+        0x06, 0x60, 0xFF,             // UsagePage(USBreezeUsagePage[0xFF60])
+        0x09, 0x02,                   // UsageId(USBreezeLampStream[0x0002])
+        0xA1, 0x01,                   // Collection(Application)
+        0x85, 0x07,                   //     ReportId(7)
+        0x09, 0x03,                   //     UsageId(RgbStreamReport[0x0003])
+        0xA1, 0x02,                   //     Collection(Logical)
+        0x09, 0x04,                   //         UsageId(RgbStreamSequence[0x0004])
+        0x09, 0x05,                   //         UsageId(RgbStreamFlags[0x0005])
+        0x09, 0x06,                   //         UsageId(RgbStreamSliceId[0x0006])
+        0x26, 0xFF, 0x00,             //         LogicalMaximum(255)
+        0x95, 0x03,                   //         ReportCount(3)
+        0x91, 0x02,                   //         Output(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0x09, 0x07,                   //         UsageId(RgbStreamColors[0x0007])
+        0x95, 0x3C,                   //         ReportCount(60)
+        0x91, 0x02,                   //         Output(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0xC0,                         //     EndCollection()
+        0x85, 0x08,                   //     ReportId(8)
+        0x09, 0x08,                   //     UsageId(RgbOpsReport[0x0008])
+        0xA1, 0x02,                   //     Collection(Logical)
+        0x09, 0x09,                   //         UsageId(RgbOpsFlags[0x0009])
+        0x95, 0x01,                   //         ReportCount(1)
+        0x91, 0x02,                   //         Output(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0x09, 0x0A,                   //         UsageId(RgbOpsLampIdStart[0x000A])
+        0x27, 0xFF, 0xFF, 0x00, 0x00, //         LogicalMaximum(65,535)
+        0x75, 0x10,                   //         ReportSize(16)
+        0x91, 0x02,                   //         Output(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0x09, 0x0B,                   //         UsageId(RgbOpsData[0x000B])
+        0x26, 0xFF, 0x00,             //         LogicalMaximum(255)
+        0x95, 0x3C,                   //         ReportCount(60)
+        0x75, 0x08,                   //         ReportSize(8)
+        0x91, 0x02,                   //         Output(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0xC0,                         //     EndCollection()
+        0x85, 0x09,                   //     ReportId(9)
+        0x09, 0x0C,                   //     UsageId(RgbPaletteReport[0x000C])
+        0xA1, 0x02,                   //     Collection(Logical)
+        0x09, 0x0D,                   //         UsageId(RgbPaletteFlags[0x000D])
+        0x09, 0x0E,                   //         UsageId(RgbPaletteFirstIndex[0x000E])
+        0x95, 0x02,                   //         ReportCount(2)
+        0x91, 0x02,                   //         Output(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0x09, 0x0F,                   //         UsageId(RgbPaletteColors[0x000F])
+        0x95, 0x3C,                   //         ReportCount(60)
+        0x91, 0x02,                   //         Output(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0xC0,                         //     EndCollection()
+        0x85, 0x0A,                   //     ReportId(10)
+        0x09, 0x24,                   //     UsageId(RgbIndexReport[0x0024])
+        0xA1, 0x02,                   //     Collection(Logical)
+        0x09, 0x25,                   //         UsageId(RgbIndexFlags[0x0025])
+        0x95, 0x01,                   //         ReportCount(1)
+        0x91, 0x02,                   //         Output(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0x09, 0x26,                   //         UsageId(RgbIndexLampIdStart[0x0026])
+        0x27, 0xFF, 0xFF, 0x00, 0x00, //         LogicalMaximum(65,535)
+        0x75, 0x10,                   //         ReportSize(16)
+        0x91, 0x02,                   //         Output(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0x09, 0x27,                   //         UsageId(RgbIndexLampIndexes[0x0027])
+        0x26, 0xFF, 0x00,             //         LogicalMaximum(255)
+        0x95, 0x3C,                   //         ReportCount(60)
+        0x75, 0x08,                   //         ReportSize(8)
+        0x91, 0x02,                   //         Output(Data, Variable, Absolute, NoWrap, Linear, PreferredState, NoNullPosition, NonVolatile, BitField)
+        0xC0,                         //     EndCollection()
+        0xC0,                         // EndCollection()
 };
 
 /* Have to write like this to make rl_usb lib happy */
@@ -253,6 +321,25 @@ static bool USBD_HID_SetReport(uint8_t instance, uint8_t rtype, uint8_t req, uin
   switch (rtype)
   {
   case HID_REPORT_OUTPUT:
+    // Interrupt OUT reports arrive in the HID class thread of the instance, not the USB core thread
+    // The first byte of data is report ID
+    len--;
+    buf++;
+
+    switch (rid)
+    {
+    case RGB_LAMP_STREAM_REPORT_ID:
+      return RGB_Control_Set_Stream_Slice(instance, buf, len);
+    case RGB_LAMP_OPS_REPORT_ID:
+      return RGB_Control_Set_Ops_Update(instance, buf, len);
+    case RGB_LAMP_PALETTE_REPORT_ID:
+      return RGB_Control_Set_Palette_Update(instance, buf, len);
+    case RGB_LAMP_INDEX_REPORT_ID:
+      return RGB_Control_Set_Index_Update(instance, buf, len);
+
+    default:
+      break;
+    }
     break;
 
   case HID_REPORT_FEATURE:
@@ -9,6 +9,9 @@
 static void GPIO_Initialize(void);
 static void GPIO_EXTI_Initialize(void);
 static void TIM1_Initialize(void);
+#if RGB_SPI_PHY_CHANNEL >= 0
+static void SPI1_Initialize(void);
+#endif
 static void TIM2_Initialize(void);
 static void TIM3_Initialize(void);
 static void ADC_Initialize(void);
@@ -19,6 +22,9 @@ void BSP_Initialize(void)
 	GPIO_Initialize();
 	GPIO_EXTI_Initialize();
 	TIM1_Initialize();
+#if RGB_SPI_PHY_CHANNEL >= 0
+	SPI1_Initialize();
+#endif
 	TIM2_Initialize();
 	TIM3_Initialize();
 	ADC_Initialize();
@@ -64,6 +70,85 @@ static void GPIO_Initialize(void)
 	GPIO_ResetBits(GPIOB, GPIO_Pin_8 | GPIO_Pin_9 | GPIO_Pin_10 | GPIO_Pin_11 | GPIO_Pin_12 | GPIO_Pin_13 | GPIO_Pin_14 | GPIO_Pin_15);
 }
 
+#if RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+static const uint32_t RGB_Parallel_Pin_Mask = RGB_PARALLEL_PIN_MASK; // DMA source of the set-all / clear-all writes
+
+static void TIM1_Initialize(void)
+{
+	GPIO_InitTypeDef GPIO_InitStructure;
+	TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+	TIM_OCInitTypeDef TIM_OCInitStructure;
+	DMA_InitTypeDef DMA_InitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	RCC_APB2PeriphClockCmd(RCC_APB2Periph_TIM1, ENABLE);
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+	/* WS2812 pins driven by DMA writes to BSRR / BRR, overrides the AF config of PA8-10 */
+	GPIO_InitStructure.GPIO_Pin = RGB_PARALLEL_PIN_MASK;
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP;
+	GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+	GPIO_Init(RGB_WS2812_PORT, &GPIO_InitStructure);
+	GPIO_ResetBits(RGB_WS2812_PORT, RGB_PARALLEL_PIN_MASK);
+
+	TIM_InternalClockConfig(TIM1);
+
+	/* TIM1 Config, only generates DMA requests */
+	TIM_TimeBaseStructInit(&TIM_TimeBaseStructure);
+	TIM_TimeBaseStructure.TIM_Period = RGB_WS2812_ARR - 1;
+	TIM_TimeBaseStructure.TIM_Prescaler = 0; // No Prescaler
+	TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+	TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+	TIM_TimeBaseInit(TIM1, &TIM_TimeBaseStructure);
+
+	TIM_OCStructInit(&TIM_OCInitStructure);
+	TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_Timing;
+	TIM_OCInitStructure.TIM_OutputState = TIM_OutputState_Disable;
+	TIM_OCInitStructure.TIM_Pulse = RGB_WS2812_T0H;
+	TIM_OC1Init(TIM1, &TIM_OCInitStructure); // CC1 at T0H: clear pins of 0bits
+	TIM_OCInitStructure.TIM_Pulse = RGB_WS2812_T1H;
+	TIM_OC2Init(TIM1, &TIM_OCInitStructure); // CC2 at T1H: clear all pins
+
+	TIM_Cmd(TIM1, DISABLE);
+
+	/* DMA1 CH5, TIM1 UP: set all pins */
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&(RGB_WS2812_PORT->BSRR);
+	DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)&RGB_Parallel_Pin_Mask;
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+	DMA_InitStructure.DMA_BufferSize = 1;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Disable;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Word;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+	DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+	DMA_Init(DMA1_Channel5, &DMA_InitStructure);
+
+	/* DMA1 CH3, TIM1 CC2: clear all pins */
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&(RGB_WS2812_PORT->BRR);
+	DMA_Init(DMA1_Channel3, &DMA_InitStructure);
+
+	/* DMA1 CH2, TIM1 CC1: clear pins of 0bits, from the ping-pong buffer */
+	DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)RGB_WS2812_Buffer;
+	DMA_InitStructure.DMA_BufferSize = RGB_WS2812_BUFFER_SIZE;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord; // Zero-extended to 32bit
+	DMA_Init(DMA1_Channel2, &DMA_InitStructure);
+
+	DMA_ITConfig(DMA1_Channel2, DMA_IT_HT | DMA_IT_TC, ENABLE); // Interrupt on DMA half done / all done
+
+	NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel2_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 0; // High as possible
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+
+	DMA_Cmd(DMA1_Channel2, DISABLE); // Disable for now
+	DMA_Cmd(DMA1_Channel3, DISABLE);
+	DMA_Cmd(DMA1_Channel5, DISABLE);
+}
+#else
 static void TIM1_Initialize(void)
 {
 	TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
@@ -115,7 +200,11 @@ static void TIM1_Initialize(void)
 	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;			// ReceiveBuff Addr Fixed
 	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;						// SendBuff Addr increasing
 	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord; // ReceiveBuff data size, 16bit
+#if RGB_WS2812_BYTE_BUFFER
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;				// SENDBUFF_SIZE data size, 8bit. DMA zero-extends to 16bit
+#else
 	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;			// SENDBUFF_SIZE data size, 16bit
+#endif
 	DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;								// Circular!!!!
 	DMA_InitStructure.DMA_Priority = DMA_Priority_High;							// Priority High
 	DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;								// Not memory to memory
@@ -131,6 +220,64 @@ static void TIM1_Initialize(void)
 
 	DMA_Cmd(DMA1_Channel5, DISABLE); // Disable for now
 }
+#endif
+
+#if RGB_SPI_PHY_CHANNEL >= 0
+static void SPI1_Initialize(void)
+{
+	GPIO_InitTypeDef GPIO_InitStructure;
+	SPI_InitTypeDef SPI_InitStructure;
+	DMA_InitTypeDef DMA_InitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	RCC_APB2PeriphClockCmd(RCC_APB2Periph_SPI1, ENABLE);
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+	/* GPIO B5 for SPI1 MOSI (WS2812 ARGB). PA7 is taken by TIM3 CH2, only MOSI of the remapped pins is used */
+	GPIO_PinRemapConfig(GPIO_Remap_SPI1, ENABLE);
+	GPIO_InitStructure.GPIO_Pin = GPIO_Pin_5;
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
+	GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+	GPIO_Init(GPIOB, &GPIO_InitStructure);
+
+	/* SPI1 Config, 72MHz / 32 = 2.25MHz, 3 SPI bits for 1 WS2812 bit */
+	SPI_StructInit(&SPI_InitStructure);
+	SPI_InitStructure.SPI_Direction = SPI_Direction_1Line_Tx;
+	SPI_InitStructure.SPI_Mode = SPI_Mode_Master;
+	SPI_InitStructure.SPI_DataSize = SPI_DataSize_8b;
+	SPI_InitStructure.SPI_CPOL = SPI_CPOL_Low;
+	SPI_InitStructure.SPI_CPHA = SPI_CPHA_1Edge;
+	SPI_InitStructure.SPI_NSS = SPI_NSS_Soft;
+	SPI_InitStructure.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_32;
+	SPI_InitStructure.SPI_FirstBit = SPI_FirstBit_MSB;
+	SPI_Init(SPI1, &SPI_InitStructure);
+	SPI_Cmd(SPI1, ENABLE); // Keep enabled, MOSI holds the last bit (always 0) between frames
+
+	/* DMA1 CH3 Config, SPI1 TX */
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&(SPI1->DR);
+	DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)RGB_SPI_Buffer;
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+	DMA_InitStructure.DMA_BufferSize = RGB_SPI_BUFFER_SIZE;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Circular; // Ping-pong, same as TIM1
+	DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+	DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+	DMA_Init(DMA1_Channel3, &DMA_InitStructure);
+
+	DMA_ITConfig(DMA1_Channel3, DMA_IT_HT | DMA_IT_TC, ENABLE);
+
+	NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel3_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 1; // After TIM1, it has less slack
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+
+	DMA_Cmd(DMA1_Channel3, DISABLE); // Disable for now
+}
+#endif
 
 static void TIM2_Initialize(void)
 {
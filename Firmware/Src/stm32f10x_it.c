@@ -67,23 +67,60 @@ void EXTI15_10_IRQHandler(void) // PB10-PB15
 }
 
 /**
- * @brief  This function handles DMA1 CH5 interrupt request for WS2812 Control.
+ * @brief  This function handles DMA1 CH5 (CH2 with GPIO_PARALLEL backend) interrupt request for WS2812 Control.
  * @param  None
  * @retval None
  */
+#if RGB_PHY_BACKEND == RGB_PHY_BACKEND_GPIO_PARALLEL
+void DMA1_Channel2_IRQHandler(void)
+{
+    if (DMA_GetITStatus(DMA1_IT_HT2))
+    { // Former half buffer sent. Start reload
+        DMA_ClearITPendingBit(DMA1_IT_HT2);
+        RGB_Control_Half_Buffer_Sent(0);
+    }
+    if (DMA_GetITStatus(DMA1_IT_TC2))
+    { // Latter half buffer sent. Start reload
+        DMA_ClearITPendingBit(DMA1_IT_TC2);
+        RGB_Control_Half_Buffer_Sent(1);
+    }
+}
+#else
 void DMA1_Channel5_IRQHandler(void)
 {
     if (DMA_GetITStatus(DMA1_IT_HT5))
     { // Former half buffer sent. Start reload
         DMA_ClearITPendingBit(DMA1_IT_HT5);
-        RGB_Control_Fill_Half_Buffer(0);
+        RGB_Control_Half_Buffer_Sent(0);
     }
     if (DMA_GetITStatus(DMA1_IT_TC5))
     { // Latter half buffer sent. Start reload
         DMA_ClearITPendingBit(DMA1_IT_TC5);
-        RGB_Control_Fill_Half_Buffer(1);
+        RGB_Control_Half_Buffer_Sent(1);
+    }
+}
+#endif
+
+#if RGB_SPI_PHY_CHANNEL >= 0
+/**
+ * @brief  This function handles DMA1 CH3 interrupt request for WS2812 over SPI1.
+ * @param  None
+ * @retval None
+ */
+void DMA1_Channel3_IRQHandler(void)
+{
+    if (DMA_GetITStatus(DMA1_IT_HT3))
+    {
+        DMA_ClearITPendingBit(DMA1_IT_HT3);
+        RGB_Control_SPI_Half_Buffer_Sent(0);
+    }
+    if (DMA_GetITStatus(DMA1_IT_TC3))
+    {
+        DMA_ClearITPendingBit(DMA1_IT_TC3);
+        RGB_Control_SPI_Half_Buffer_Sent(1);
     }
 }
+#endif
 
 /**
  * @}
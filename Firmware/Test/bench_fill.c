@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+    Fill benchmark: ns per RGB_Encoder_Fill_Half_Buffer with every channel sending BENCH_FORMAT lamps, GRB by default.
+    Host times only rank encoders against each other, the budget on target is one half
+    of bit-times (RGB_WS2812_LAMPS_PER_HALF * 30us with WS2812B timing).
+*/
+
+#include <time.h>
+
+#include "test_common.h"
+
+#define BENCH_FRAMES            20000
+#define BENCH_FILLS             64      // Per frame, all within the lamps of the chains
+#ifndef BENCH_FORMAT
+#define BENCH_FORMAT            RGB_PIXEL_FORMAT_GRB
+#endif
+
+static double Bench_Now_Ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+int main(void)
+{
+    static const RGB_Lamp_Segment segment = {0, TEST_LAMPS, RGB_SEGMENT_FORWARD, 0};
+    long fills = 0;
+
+    srand(4);
+    Test_Setup_Encoder(RGB_WS2812_TIMING_WS2812B);
+    for (int i = 0; i < (int)sizeof(Test_Colors); i++)
+        Test_Colors[i] = rand();
+    for (int ch = 0; ch < TEST_CHANNELS; ch++)
+    {
+        Test_Chains[ch] = &segment;
+        Test_Chain_Lamps[ch] = TEST_LAMPS;
+        Test_Formats[ch] = BENCH_FORMAT;
+    }
+
+    double start = Bench_Now_Ns();
+    for (int frame = 0; frame < BENCH_FRAMES; frame++)
+    {
+        RGB_Encoder_Begin_Frame(Test_Colors, Test_Chains, Test_Chain_Lamps, Test_Formats);
+        for (int k = 0; k < BENCH_FILLS; k++, fills++)
+            RGB_Encoder_Fill_Half_Buffer(k & 1);
+    }
+
+    printf("bench %-24s %6.1f ns/half-fill (%d lamps x %d channels)\n", BENCH_NAME, (Bench_Now_Ns() - start) / fills,
+           RGB_WS2812_LAMPS_PER_HALF, TEST_CHANNELS);
+    return 0;
+}
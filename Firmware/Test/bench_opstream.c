@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+    Op stream benchmark: ns per ops report, validated and then applied like the ops report
+    handler does in one mutex hold. Mixed skips, runs and literals filling the whole report.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "RGBOpStream.h"
+
+#define BENCH_REPORTS           2000000
+#define BENCH_OPS_BYTES         60      // RGB_LAMP_OPS_BYTES of the ops report
+#define BENCH_LAMPS             256
+
+static volatile uint8_t Lamps[BENCH_LAMPS][3];
+
+static void Sink(uint16_t lamp, uint16_t count, const uint8_t *colors, uint8_t stride)
+{
+    for (int i = 0; i < count; i++, colors += stride)
+    {
+        Lamps[lamp + i][0] = colors[0];
+        Lamps[lamp + i][1] = colors[1];
+        Lamps[lamp + i][2] = colors[2];
+    }
+}
+
+static double Bench_Now_Ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+int main(void)
+{
+    uint8_t ops[BENCH_OPS_BYTES] = {0};
+    int n = 0, lamps = 0;
+
+    // Skip 10, run of 40, literal of 8, skip 5, run of 63, literal of 4, ... until the report is full
+    static const uint8_t pattern[][2] = {{RGB_OP_SKIP, 10}, {RGB_OP_RUN, 40}, {RGB_OP_LITERAL, 8}, {RGB_OP_SKIP, 5}, {RGB_OP_RUN, 63}, {RGB_OP_LITERAL, 4}};
+    for (int k = 0;; k++)
+    {
+        const uint8_t *p = pattern[k % 6];
+        int payload = p[0] == RGB_OP_SKIP ? 0 : p[0] == RGB_OP_RUN ? 3 : 3 * p[1];
+        if (n + 1 + payload > BENCH_OPS_BYTES || lamps + p[1] > BENCH_LAMPS)
+            break;
+        ops[n++] = p[0] | p[1];
+        for (int i = 0; i < payload; i++, n++)
+            ops[n] = n * 7;
+        lamps += p[1];
+    }
+
+    uint16_t first, last;
+    long ok = 0;
+    double start = Bench_Now_Ns();
+    for (long r = 0; r < BENCH_REPORTS; r++)
+    {
+        if (RGB_Op_Stream_Decode(ops, sizeof(ops), 0, BENCH_LAMPS, NULL, &first, &last))
+            ok += RGB_Op_Stream_Decode(ops, sizeof(ops), 0, BENCH_LAMPS, Sink, &first, &last);
+    }
+
+    printf("bench %-24s %6.1f ns/report (%d lamps, %d op bytes)\n", "opstream", (Bench_Now_Ns() - start) / BENCH_REPORTS,
+           lamps, n);
+    return ok != BENCH_REPORTS;
+}
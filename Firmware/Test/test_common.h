@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _TEST_COMMON_H
+#define _TEST_COMMON_H
+
+/*
+    Reference model shared by the host verifiers: random chains and the byte stream
+    each phy channel has to carry, computed without the encoder.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RGBEncoder.h"
+
+#define TEST_LAMPS              256
+#define TEST_SEGMENTS           4       // Per chain
+#define TEST_MAX_BYTES          (TEST_SEGMENTS * TEST_LAMPS * 4 + 3)
+#define TEST_CHANNELS           RGB_CONTROL_PHY_CHANNELS_COUNT
+
+static volatile uint8_t Test_Colors[TEST_LAMPS * RGB_LAMP_STORAGE_BYTES];
+static uint8_t Test_Palette[256][RGB_CHANNELS_PER_LAMP];
+static RGB_Lamp_Segment Test_Segments[TEST_CHANNELS][TEST_SEGMENTS];
+static const RGB_Lamp_Segment *Test_Chains[TEST_CHANNELS];
+static uint16_t Test_Chain_Lamps[TEST_CHANNELS];
+static uint8_t Test_Formats[TEST_CHANNELS];
+
+/* Identity correction, palette and power scale, as after power-up */
+static void Test_Setup_Encoder(int profile)
+{
+    static uint8_t gains[TEST_CHANNELS][RGB_CHANNELS_PER_LAMP];
+    memset(gains, 255, sizeof(gains));
+
+    for (int i = 0; i < 256; i++)
+        for (int c = 0; c < RGB_CHANNELS_PER_LAMP; c++)
+            Test_Palette[i][c] = rand();
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+    RGB_Encoder_Set_Palette((const uint8_t (*)[RGB_CHANNELS_PER_LAMP])Test_Palette);
+#endif
+    RGB_Encoder_Set_Timing(&RGB_WS2812_Timing_Profiles[profile]);
+    RGB_Encoder_Set_Correction(RGB_CORRECTION_GAMMA_LINEAR, 255, (const uint8_t (*)[RGB_CHANNELS_PER_LAMP])gains);
+    RGB_Encoder_Set_Dither(0);
+    RGB_Encoder_Set_Power_Scale(256);
+}
+
+/* Random colors, 0..3 segments of any mode per chain. prefix: sometimes only a dirty prefix of a chain */
+static void Test_Random_Frame(int formats, int prefix)
+{
+    for (int i = 0; i < (int)sizeof(Test_Colors); i++)
+        Test_Colors[i] = rand();
+
+    for (int ch = 0; ch < TEST_CHANNELS; ch++)
+    {
+        int segments = rand() % TEST_SEGMENTS;
+        Test_Chains[ch] = Test_Segments[ch];
+        Test_Chain_Lamps[ch] = 0;
+        for (int k = 0; k < segments; k++)
+        {
+            RGB_Lamp_Segment *seg = &Test_Segments[ch][k];
+            seg->Mode = rand() % RGB_SEGMENT_MODE_COUNT;
+            seg->Width = 0;
+            if (seg->Mode == RGB_SEGMENT_SERPENTINE)
+            {
+                seg->Width = 1 + rand() % 16;
+                seg->Count = seg->Width * (1 + rand() % 6);
+            }
+            else
+                seg->Count = 1 + rand() % 100;
+            seg->Start = rand() % (TEST_LAMPS - seg->Count + 1);
+            Test_Chain_Lamps[ch] += seg->Count;
+        }
+        if (prefix && Test_Chain_Lamps[ch] && rand() % 3 == 0)
+            Test_Chain_Lamps[ch] = rand() % Test_Chain_Lamps[ch] + 1;
+        Test_Formats[ch] = rand() % formats;
+    }
+}
+
+/* Framebuffer lamp sent at position pos of a chain */
+static int Test_Chain_Lamp(const RGB_Lamp_Segment *chain, int pos)
+{
+    for (;; chain++)
+    {
+        if (pos >= chain->Count)
+        {
+            pos -= chain->Count;
+            continue;
+        }
+        if (chain->Mode == RGB_SEGMENT_REVERSE)
+            return chain->Start + chain->Count - 1 - pos;
+        if (chain->Mode == RGB_SEGMENT_SERPENTINE && (pos / chain->Width) % 2)
+            return chain->Start + (pos / chain->Width + 1) * chain->Width - 1 - pos % chain->Width;
+        return chain->Start + pos;
+    }
+}
+
+static void Test_Load_Lamp(int lamp, uint8_t *rgb)
+{
+    const volatile uint8_t *s = &Test_Colors[lamp * RGB_LAMP_STORAGE_BYTES];
+#if RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_RGB565
+    uint16_t v = s[0] | (s[1] << 8);
+    rgb[0] = RGB_565_RED(v);
+    rgb[1] = RGB_565_GREEN(v);
+    rgb[2] = RGB_565_BLUE(v);
+#elif RGB_LAMP_STORAGE == RGB_LAMP_STORAGE_PALETTE
+    memcpy(rgb, Test_Palette[s[0] & (RGB_LAMP_PALETTE_SIZE - 1)], RGB_CHANNELS_PER_LAMP);
+#else
+    rgb[0] = s[0];
+    rgb[1] = s[1];
+    rgb[2] = s[2];
+#endif
+}
+
+/* Bytes of a channel in wire order, padded with 0 to whole 24 bit slots. Returns the count */
+static int Test_Expected_Bytes(int ch, uint8_t *out)
+{
+    int n = 0;
+    for (int pos = 0; pos < Test_Chain_Lamps[ch]; pos++)
+    {
+        uint8_t p[RGB_CHANNELS_PER_LAMP];
+        Test_Load_Lamp(Test_Chain_Lamp(Test_Chains[ch], pos), p);
+        switch (Test_Formats[ch])
+        {
+        case RGB_PIXEL_FORMAT_GRB:
+            out[n++] = p[1]; out[n++] = p[0]; out[n++] = p[2];
+            break;
+        case RGB_PIXEL_FORMAT_RGB:
+            out[n++] = p[0]; out[n++] = p[1]; out[n++] = p[2];
+            break;
+        case RGB_PIXEL_FORMAT_BRG:
+            out[n++] = p[2]; out[n++] = p[0]; out[n++] = p[1];
+            break;
+        case RGB_PIXEL_FORMAT_GRBW:
+        {
+            uint8_t w = p[0] < p[1] ? p[0] : p[1];
+            w = w < p[2] ? w : p[2];
+            out[n++] = p[1] - w; out[n++] = p[0] - w; out[n++] = p[2] - w; out[n++] = w;
+            break;
+        }
+        }
+    }
+    while (n % 3)
+        out[n++] = 0;
+    return n;
+}
+
+/* Compare decoded bits with the expected bytes. frame_bits: bits every channel clocks, 0bits after the lamps. 0 for just the lamps */
+static int Test_Check_Bits(const char *name, int it, int ch, const uint8_t *bits, int nbits, int frame_bits)
+{
+    static uint8_t expected[TEST_MAX_BYTES];
+    int n = Test_Expected_Bytes(ch, expected);
+    int want = frame_bits > n * 8 ? frame_bits : n * 8;
+
+    if (nbits != want)
+    {
+        printf("%s: frame %d ch%d has %d bits, expected %d\n", name, it, ch, nbits, want);
+        return 1;
+    }
+    for (int k = 0; k < n; k++)
+    {
+        int v = 0;
+        for (int b = 0; b < 8; b++)
+            v = (v << 1) | bits[k * 8 + b];
+        if (v != expected[k])
+        {
+            printf("%s: frame %d ch%d byte %d is %02x, expected %02x\n", name, it, ch, k, v, expected[k]);
+            return 1;
+        }
+    }
+    for (int b = n * 8; b < nbits; b++)
+    {
+        if (bits[b])
+        {
+            printf("%s: frame %d ch%d has a 1bit after its lamps\n", name, it, ch);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#endif
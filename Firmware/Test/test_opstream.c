@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+    Op stream decoder checks: random frames encoded into skip / run / literal ops and decoded back,
+    the boundaries of every op, and random bytes that must never write outside start..lamp_count-1.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RGBOpStream.h"
+
+#define TEST_OPS_BYTES          60      // RGB_LAMP_OPS_BYTES of the ops report
+#define TEST_LAMPS              512
+#define TEST_ROUND_TRIPS        20000
+#define TEST_FUZZ               200000
+
+static uint8_t Lamps[TEST_LAMPS][3];
+static int Sink_Fails;
+static const uint8_t *Sink_Ops;
+static int32_t Sink_Len;
+static uint16_t Sink_Start, Sink_Lamp_Count;
+
+/* Writes the span into Lamps (lamps past TEST_LAMPS only checked), fails on any lamp or color byte out of bounds */
+static void Sink(uint16_t lamp, uint16_t count, const uint8_t *colors, uint8_t stride)
+{
+    if (count == 0 || lamp < Sink_Start || lamp + count > Sink_Lamp_Count ||
+        colors < Sink_Ops || colors + stride * (count - 1) + 3 > Sink_Ops + Sink_Len)
+    {
+        Sink_Fails++;
+        return;
+    }
+    for (int i = 0; i < count && lamp + i < TEST_LAMPS; i++, colors += stride)
+        memcpy(Lamps[lamp + i], colors, 3);
+}
+
+static bool Decode(const uint8_t *ops, int32_t len, uint16_t start, uint16_t lamp_count, uint16_t *first, uint16_t *last)
+{
+    Sink_Ops = ops;
+    Sink_Len = len;
+    Sink_Start = start;
+    Sink_Lamp_Count = lamp_count;
+    return RGB_Op_Stream_Decode(ops, len, start, lamp_count, Sink, first, last);
+}
+
+/*
+    Reference encoder: lamps with keep[] set are skipped, equal neighbors become runs, the rest literals.
+    Returns the stream length, -1 if it does not fit in max bytes.
+*/
+static int Encode(const uint8_t (*colors)[3], const uint8_t *keep, int lamps, uint8_t *ops, int max)
+{
+    int n = 0;
+
+    for (int i = 0; i < lamps;)
+    {
+        int count = 1;
+        if (keep[i])
+        {
+            while (i + count < lamps && count < RGB_OP_COUNT_MASK && keep[i + count])
+                count++;
+            if (n + 1 > max)
+                return -1;
+            ops[n++] = RGB_OP_SKIP | count;
+        }
+        else if (i + 1 < lamps && !keep[i + 1] && !memcmp(colors[i], colors[i + 1], 3))
+        {
+            while (i + count < lamps && count < RGB_OP_COUNT_MASK && !keep[i + count] && !memcmp(colors[i], colors[i + count], 3))
+                count++;
+            if (n + 4 > max)
+                return -1;
+            ops[n++] = RGB_OP_RUN | count;
+            memcpy(&ops[n], colors[i], 3);
+            n += 3;
+        }
+        else
+        {
+            while (i + count < lamps && count < RGB_OP_COUNT_MASK && !keep[i + count] &&
+                   (i + count + 1 >= lamps || memcmp(colors[i + count], colors[i + count + 1], 3)))
+                count++;
+            if (n + 1 + 3 * count > max)
+                return -1;
+            ops[n++] = RGB_OP_LITERAL | count;
+            memcpy(&ops[n], colors[i], 3 * count);
+            n += 3 * count;
+        }
+        i += count;
+    }
+    return n;
+}
+
+static int Round_Trips(void)
+{
+    static uint8_t colors[TEST_LAMPS][3], expected[TEST_LAMPS][3];
+    static uint8_t keep[TEST_LAMPS];
+    uint8_t ops[TEST_OPS_BYTES];
+    int fails = 0;
+
+    for (int it = 0; it < TEST_ROUND_TRIPS; it++)
+    {
+        int lamps = 1 + rand() % 200;
+        int start = rand() % (TEST_LAMPS - lamps + 1);
+        int spread = 1 + rand() % 4;        // Few colors, so runs happen
+        int n;
+
+        for (int i = 0; i < lamps; i++)
+        {
+            keep[i] = rand() % 4 == 0;
+            for (int c = 0; c < 3; c++)
+                colors[i][c] = rand() % spread;
+        }
+        while ((n = Encode((const uint8_t (*)[3])colors, keep, lamps, ops, sizeof(ops))) < 0)
+            lamps--;                        // Shrink until the frame fits one report
+        memset(&ops[n], 0, sizeof(ops) - n);
+
+        int want_first = -1, want_last = -1;
+        memset(Lamps, 0xEE, sizeof(Lamps));
+        memcpy(expected, Lamps, sizeof(expected));
+        for (int i = 0; i < lamps; i++)
+        {
+            if (keep[i])
+                continue;
+            memcpy(expected[start + i], colors[i], 3);
+            if (want_first < 0)
+                want_first = start + i;
+            want_last = start + i;
+        }
+
+        uint16_t first, last;
+        Sink_Fails = 0;
+        if (!Decode(ops, sizeof(ops), start, start + lamps, &first, &last) || Sink_Fails)
+        {
+            printf("opstream: round trip %d rejected\n", it);
+            fails++;
+            continue;
+        }
+        if (memcmp(Lamps, expected, sizeof(Lamps)) ||
+            (want_first < 0 ? first <= last : first != want_first || last != want_last))
+        {
+            printf("opstream: round trip %d decoded %u..%u, expected %d..%d\n", it, first, last, want_first, want_last);
+            fails++;
+        }
+    }
+    return fails;
+}
+
+static int Expect(const char *name, const uint8_t *ops, int32_t len, uint16_t start, uint16_t lamp_count,
+                  bool ok, int first_want, int last_want)
+{
+    uint16_t first, last;
+    Sink_Fails = 0;
+    bool got = Decode(ops, len, start, lamp_count, &first, &last);
+
+    if (got != ok || Sink_Fails)
+    {
+        printf("opstream: %s returned %d, expected %d\n", name, got, ok);
+        return 1;
+    }
+    if (ok && (first_want < 0 ? first <= last : first != first_want || last != last_want))
+    {
+        printf("opstream: %s range %u..%u, expected %d..%d\n", name, first, last, first_want, last_want);
+        return 1;
+    }
+    return 0;
+}
+
+static int Boundaries(void)
+{
+    static uint8_t literal[1 + 3 * RGB_OP_COUNT_MASK];
+    int fails = 0;
+
+    for (int i = 0; i < (int)sizeof(literal); i++)
+        literal[i] = i;
+    literal[0] = RGB_OP_LITERAL | RGB_OP_COUNT_MASK;
+
+    const uint8_t empty[] = {0x00, 0x41, 1, 2, 3};
+    const uint8_t run_max[] = {RGB_OP_RUN | RGB_OP_COUNT_MASK, 1, 2, 3};
+    const uint8_t skip_max[] = {RGB_OP_SKIP | RGB_OP_COUNT_MASK, RGB_OP_RUN | 1, 1, 2, 3};
+    const uint8_t run_zero[] = {RGB_OP_RUN, 1, 2, 3};
+    const uint8_t literal_zero[] = {RGB_OP_LITERAL, 1, 2, 3};
+    const uint8_t reserved[] = {RGB_OP_MASK | 1, 1, 2, 3};
+    const uint8_t truncated_run[] = {RGB_OP_RUN | 1, 1, 2};
+    const uint8_t skip_run[] = {RGB_OP_SKIP | 2, RGB_OP_RUN | 3, 1, 2, 3};
+
+    fails += Expect("no bytes", empty, 0, 0, 10, true, -1, -1);
+    fails += Expect("end marker", empty, sizeof(empty), 0, 10, true, -1, -1);
+    fails += Expect("empty at the end", empty, sizeof(empty), 10, 10, true, -1, -1);
+    fails += Expect("run of 0", run_zero, sizeof(run_zero), 0, 10, false, 0, 0);
+    fails += Expect("literal of 0", literal_zero, sizeof(literal_zero), 0, 10, false, 0, 0);
+    fails += Expect("reserved op", reserved, sizeof(reserved), 0, 10, false, 0, 0);
+    fails += Expect("truncated run", truncated_run, sizeof(truncated_run), 0, 10, false, 0, 0);
+    fails += Expect("skip then run", skip_run, sizeof(skip_run), 5, 10, true, 7, 9);
+    fails += Expect("skip then run past the end", skip_run, sizeof(skip_run), 6, 10, false, 0, 0);
+    fails += Expect("max run", run_max, sizeof(run_max), 1, 64, true, 1, 63);
+    fails += Expect("max run past the end", run_max, sizeof(run_max), 2, 64, false, 0, 0);
+    fails += Expect("max skip", skip_max, sizeof(skip_max), 0, 64, true, 63, 63);
+    fails += Expect("max skip past the end", skip_max, 1, 2, 64, false, 0, 0);
+    fails += Expect("max literal", literal, sizeof(literal), 0xFFFF - 63, 0xFFFF, true, 0xFFFF - 63, 0xFFFF - 1);
+    fails += Expect("truncated literal", literal, sizeof(literal) - 1, 0, 64, false, 0, 0);
+    fails += Expect("literal header only", literal, 1, 0, 64, false, 0, 0);
+
+    // Literal colors come from the stream in order
+    memset(Lamps, 0, sizeof(Lamps));
+    Expect("literal colors", literal, sizeof(literal), 100, 200, true, 100, 162);
+    for (int i = 0; i < RGB_OP_COUNT_MASK; i++)
+    {
+        if (memcmp(Lamps[100 + i], &literal[1 + 3 * i], 3))
+        {
+            printf("opstream: literal lamp %d has the wrong color\n", i);
+            fails++;
+            break;
+        }
+    }
+    return fails;
+}
+
+/* Random bytes, biased to valid headers: the sink stays in bounds and validation agrees with decoding */
+static int Fuzz(void)
+{
+    uint8_t ops[TEST_OPS_BYTES];
+    int fails = 0;
+
+    for (int it = 0; it < TEST_FUZZ; it++)
+    {
+        int32_t len = rand() % (TEST_OPS_BYTES + 1);
+        uint16_t lamp_count = rand() % 2 ? rand() % TEST_LAMPS : 0xFFFF - rand() % 128;
+        uint16_t start = lamp_count ? rand() % (lamp_count + 1) : 0;
+        for (int i = 0; i < len; i++)
+            ops[i] = rand() % 4 ? rand() : (rand() % 3) << 6 | (1 + rand() % 4);
+
+        uint16_t first, last, vfirst, vlast;
+        bool valid = RGB_Op_Stream_Decode(ops, len, start, lamp_count, NULL, &vfirst, &vlast);
+        Sink_Fails = 0;
+        bool ok = Decode(ops, len, start, lamp_count, &first, &last);
+
+        if (Sink_Fails || ok != valid || (ok && (first != vfirst || last != vlast)) ||
+            (ok && first <= last && (first < start || last >= lamp_count)))
+        {
+            printf("opstream: fuzz %d out of bounds or inconsistent\n", it);
+            fails++;
+        }
+    }
+    return fails;
+}
+
+int main(void)
+{
+    int fails = 0;
+
+    srand(5);
+    fails += Round_Trips();
+    fails += Boundaries();
+    fails += Fuzz();
+
+    printf("opstream: %s, %d round trips, %d fuzz streams\n", fails ? "FAIL" : "OK", TEST_ROUND_TRIPS, TEST_FUZZ);
+    return fails != 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+    GPIO_PARALLEL verifier, built with RGB_PHY_BACKEND=RGB_PHY_BACKEND_GPIO_PARALLEL.
+    Decodes the BRR words of every played half, a set pin is a 0bit. The controller sends whole
+    chains on this backend, shorter channels send 0bits until the longest one and the reset are done.
+*/
+
+#include "test_common.h"
+
+#if RGB_PHY_BACKEND != RGB_PHY_BACKEND_GPIO_PARALLEL
+#error "Build with -DRGB_PHY_BACKEND=1"
+#endif
+
+#define TEST_FRAMES             1000
+#define TEST_MAX_BITS           (TEST_MAX_BYTES * 8 + RGB_WS2812_BUFFER_SIZE)
+
+static uint8_t Bits[TEST_CHANNELS][TEST_MAX_BITS];
+static int Bit_Count[TEST_CHANNELS];
+
+static int Take_Half(int half)
+{
+    for (int k = 0; k < RGB_WS2812_HALF_BUFFER_SIZE; k++)
+    {
+        unsigned w = RGB_WS2812_Buffer[half * RGB_WS2812_HALF_BUFFER_SIZE + k];
+        if (w & ~RGB_PARALLEL_PIN_MASK)
+        {
+            printf("parallel: word %04x outside the pin mask\n", w);
+            return 1;
+        }
+        for (int ch = 0; ch < TEST_CHANNELS; ch++)
+        {
+            if (Bit_Count[ch] < TEST_MAX_BITS)
+                Bits[ch][Bit_Count[ch]++] = !((w >> (RGB_PARALLEL_FIRST_PIN + ch)) & 1);
+        }
+    }
+    return 0;
+}
+
+/* Begin_Frame preloads both halves, DMA plays them in turn until a half is sent with Frame_Done set */
+static int Play_Frame(void)
+{
+    int half = 0;
+
+    memset(Bit_Count, 0, sizeof(Bit_Count));
+    for (int halves = 0; halves < 100000; halves++, half ^= 1)
+    {
+        if (Take_Half(half))
+            return 1;
+        if (RGB_Encoder_Frame_Done())
+            return 0;
+        RGB_Encoder_Fill_Half_Buffer(half);
+    }
+
+    printf("parallel: frame never ends\n");
+    return 1;
+}
+
+/* Bits every pin clocks: slots of the longest chain and the reset slots, played in whole halves. The last filled half is never sent */
+static int Frame_Bits(void)
+{
+    static uint8_t bytes[TEST_MAX_BYTES];
+    const RGB_WS2812_Timing *timing = &RGB_WS2812_Timing_Profiles[RGB_WS2812_TIMING_WS2812B];
+    int slots = 0;
+
+    for (int ch = 0; ch < TEST_CHANNELS; ch++)
+    {
+        int n = Test_Expected_Bytes(ch, bytes) / 3;
+        if (n > slots)
+            slots = n;
+    }
+    slots += (RGB_WS2812_RESET_BITS(timing) + RGB_WS2812_BITS_PER_LED - 1) / RGB_WS2812_BITS_PER_LED;
+
+    int filled = (slots + RGB_WS2812_LAMPS_PER_HALF - 1) / RGB_WS2812_LAMPS_PER_HALF;
+    int sent = filled > 2 ? filled - 1 : 1;
+    return sent * RGB_WS2812_LAMPS_PER_HALF * RGB_WS2812_BITS_PER_LED;
+}
+
+int main(void)
+{
+    int fails = 0;
+
+    srand(2);
+    Test_Setup_Encoder(RGB_WS2812_TIMING_WS2812B);
+    for (int it = 0; it < TEST_FRAMES; it++)
+    {
+        Test_Random_Frame(RGB_PIXEL_FORMAT_COUNT, 0);
+        RGB_Encoder_Begin_Frame(Test_Colors, Test_Chains, Test_Chain_Lamps, Test_Formats);
+        if (Play_Frame())
+        {
+            fails++;
+            continue;
+        }
+        int frame_bits = Frame_Bits();
+        for (int ch = 0; ch < TEST_CHANNELS; ch++)
+            fails += Test_Check_Bits("parallel", it, ch, Bits[ch], Bit_Count[ch], frame_bits);
+    }
+
+    printf("parallel: %s, %d channels x %d frames\n", fails ? "FAIL" : "OK", TEST_CHANNELS, TEST_FRAMES);
+    return fails != 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+    SPI backend verifier, built with RGB_SPI_PHY_CHANNEL set. TIM1 and SPI1 halves are played
+    in the order their DMA interrupts would come, each stream stops on its own like
+    RGB_Control_Half_Buffer_Sent / RGB_Control_SPI_Half_Buffer_Sent. The SPI symbols and the other
+    channels' compare values are decoded and compared bit for bit with the reference model.
+*/
+
+#include "test_common.h"
+
+#if RGB_SPI_PHY_CHANNEL < 0
+#error "Build with -DRGB_SPI_PHY_CHANNEL=<channel>"
+#endif
+
+#define TEST_FRAMES             300
+#define TEST_MAX_BITS           (TEST_MAX_BYTES * 8)
+
+static uint8_t Bits[TEST_CHANNELS][TEST_MAX_BITS];
+static int Bit_Count[TEST_CHANNELS];
+
+static int Take_TIM_Half(const RGB_WS2812_Timing *timing, int half)
+{
+    for (int k = 0; k < RGB_WS2812_HALF_BUFFER_SIZE; k += TEST_CHANNELS)
+    {
+        for (int ch = 0; ch < TEST_CHANNELS; ch++)
+        {
+            unsigned v = RGB_WS2812_Buffer[half * RGB_WS2812_HALF_BUFFER_SIZE + k + ch];
+            if (ch == RGB_SPI_PHY_CHANNEL ? v != 0 : (v != 0 && v != timing->T0H && v != timing->T1H))
+            {
+                printf("spi: ch%d compare value %u\n", ch, v);
+                return 1;
+            }
+            if (v && Bit_Count[ch] < TEST_MAX_BITS)
+                Bits[ch][Bit_Count[ch]++] = v == timing->T1H;
+        }
+    }
+    return 0;
+}
+
+static int Take_SPI_Half(int half)
+{
+    const volatile uint8_t *b = &RGB_SPI_Buffer[half * RGB_SPI_HALF_BUFFER_SIZE];
+    const int ch = RGB_SPI_PHY_CHANNEL;
+
+    for (int k = 0; k < RGB_SPI_HALF_BUFFER_SIZE * 8; k += 3)
+    {
+        int s = 0;
+        for (int j = k; j < k + 3; j++)
+            s = (s << 1) | ((b[j / 8] >> (7 - j % 8)) & 1);
+        if (s == 0)
+            continue;
+        if (s != RGB_SPI_T0_SYMBOL && s != RGB_SPI_T1_SYMBOL)
+        {
+            printf("spi: symbol %d\n", s);
+            return 1;
+        }
+        if (Bit_Count[ch] < TEST_MAX_BITS)
+            Bits[ch][Bit_Count[ch]++] = s == RGB_SPI_T1_SYMBOL;
+    }
+    return 0;
+}
+
+/* Both streams from Begin_Frame until each is stopped, interrupts in time order */
+static int Play_Frame(const RGB_WS2812_Timing *timing)
+{
+    const long tim_half_ns = (long)RGB_WS2812_LAMPS_PER_HALF * RGB_WS2812_BITS_PER_LED * RGB_WS2812_BIT_TIME_NS(timing);
+    const long spi_half_ns = (long)RGB_SPI_LAMPS_PER_HALF * RGB_WS2812_BITS_PER_LED * RGB_SPI_BIT_TIME_NS;
+    long tim_t = tim_half_ns, spi_t = spi_half_ns;
+    int tim_half = 0, spi_half = 0, tim_on = 1, spi_on = 1;
+
+    memset(Bit_Count, 0, sizeof(Bit_Count));
+    for (int events = 0; tim_on || spi_on; events++)
+    {
+        if (events > 100000)
+        {
+            printf("spi: frame never ends\n");
+            return 1;
+        }
+        if (tim_on && (!spi_on || tim_t <= spi_t))
+        {
+            if (Take_TIM_Half(timing, tim_half))
+                return 1;
+            if (RGB_Encoder_Frame_Done())
+                tim_on = 0;
+            else
+                RGB_Encoder_Fill_Half_Buffer(tim_half);
+            tim_half ^= 1;
+            tim_t += tim_half_ns;
+        }
+        else
+        {
+            if (Take_SPI_Half(spi_half))
+                return 1;
+            if (RGB_Encoder_Frame_Done())
+                spi_on = 0;
+            else
+                RGB_Encoder_Fill_SPI_Half_Buffer(spi_half);
+            spi_half ^= 1;
+            spi_t += spi_half_ns;
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    int fails = 0;
+
+    srand(3);
+    for (int profile = 0; profile < RGB_WS2812_TIMING_PROFILE_COUNT; profile++)
+    {
+        Test_Setup_Encoder(profile);
+
+        for (int it = 0; it < TEST_FRAMES; it++)
+        {
+            Test_Random_Frame(RGB_PIXEL_FORMAT_COUNT, 1);
+            RGB_Encoder_Begin_Frame(Test_Colors, Test_Chains, Test_Chain_Lamps, Test_Formats);
+            if (Play_Frame(&RGB_WS2812_Timing_Profiles[profile]))
+            {
+                fails++;
+                continue;
+            }
+            for (int ch = 0; ch < TEST_CHANNELS; ch++)
+                fails += Test_Check_Bits("spi", it, ch, Bits[ch], Bit_Count[ch], 0);
+        }
+    }
+
+    printf("spi: %s, channel %d, %d profiles x %d frames\n", fails ? "FAIL" : "OK", RGB_SPI_PHY_CHANNEL, RGB_WS2812_TIMING_PROFILE_COUNT, TEST_FRAMES);
+    return fails != 0;
+}
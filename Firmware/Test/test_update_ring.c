@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+    Update ring checks: a frame of many uncommitted reports must take one record and never
+    overflow into the resend-everything path, commits beyond the ring size must.
+*/
+
+#include <stdio.h>
+
+#include "RGBUpdateRing.h"
+
+static int Marks;
+static uint16_t Mark_First, Mark_Last;
+
+static void Mark(uint16_t first, uint16_t last)
+{
+    Marks++;
+    if (first < Mark_First)
+        Mark_First = first;
+    if (last > Mark_Last)
+        Mark_Last = last;
+}
+
+static int Collect(void)
+{
+    Marks = 0;
+    Mark_First = 0xFFFF;
+    Mark_Last = 0;
+    return RGB_Update_Ring_Collect(Mark);
+}
+
+static int Expect(const char *name, int commit, int marks, uint16_t first, uint16_t last)
+{
+    int got = Collect();
+    if (got != commit || Marks != marks || (marks && (Mark_First != first || Mark_Last != last)))
+    {
+        printf("update_ring: %s: commit %d, %d marks %u..%u, expected commit %d, %d marks %u..%u\n",
+               name, got, Marks, Mark_First, Mark_Last, commit, marks, first, last);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    int fails = 0;
+
+    // Multi update frame, more reports than records, committed by the last one
+    for (int i = 0; i < 4 * RGB_UPDATE_RING_SIZE; i++)
+        RGB_Update_Ring_Post(100 + 8 * i, 100 + 8 * i + 7, 0);
+    fails += Expect("uncommitted", 0, 0, 0, 0);
+    RGB_Update_Ring_Post(20, 20, 1);
+    fails += Expect("frame", 1, 1, 20, 100 + 8 * 4 * RGB_UPDATE_RING_SIZE - 1);
+
+    // Pending range was cleared by the commit, empty lamps do not widen it
+    RGB_Update_Ring_Post(1, 0, 0);
+    RGB_Update_Ring_Post(0xFFFF, 0, 1);
+    fails += Expect("empty commit", 1, 0, 0, 0);
+
+    // Each commit takes a record, collected in between
+    for (int i = 0; i < 3 * RGB_UPDATE_RING_SIZE; i++)
+    {
+        RGB_Update_Ring_Post(i, i, 0);
+        RGB_Update_Ring_Post(i + 1, i + 1, 1);
+        fails += Expect("commit", 1, 1, i, i + 1);
+    }
+
+    // A full ring of commits, then one more is lost and every lamp gets resent
+    for (int i = 0; i < RGB_UPDATE_RING_SIZE; i++)
+        RGB_Update_Ring_Post(i, i, 1);
+    fails += Expect("full", 1, RGB_UPDATE_RING_SIZE, 0, RGB_UPDATE_RING_SIZE - 1);
+    for (int i = 0; i <= RGB_UPDATE_RING_SIZE; i++)
+        RGB_Update_Ring_Post(i, i, 1);
+    fails += Expect("lost", 1, RGB_UPDATE_RING_SIZE + 1, 0, RGB_UPDATE_ALL_LAMPS);
+    fails += Expect("drained", 0, 0, 0, 0);
+
+    printf("update_ring: %s\n", fails ? "FAIL" : "OK");
+    return fails != 0;
+}
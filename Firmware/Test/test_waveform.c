@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+    TIM1_PWM verifier: plays random frames through the ping-pong buffer like the DMA does,
+    decodes the compare value stream of every channel and compares it bit for bit with the
+    reference model. Runs every timing profile.
+*/
+
+#include "test_common.h"
+
+#define TEST_FRAMES             300
+#define TEST_MAX_BITS           (TEST_MAX_BYTES * 8)
+
+static uint8_t Bits[TEST_CHANNELS][TEST_MAX_BITS];
+static int Bit_Count[TEST_CHANNELS];
+static int Reset_Bits;  // LOW bit-times after the longest channel, with the half never sent
+
+/*
+    Consume the buffer burst by burst, refilling each half when DMA would, until the frame is out.
+    The half filled with Frame_Done set is never sent, it is decoded last and must only hold reset bits.
+*/
+static int Play_Frame(const RGB_WS2812_Timing *timing)
+{
+    const int half = RGB_WS2812_HALF_BUFFER_SIZE;
+    int gap[TEST_CHANNELS] = {0};
+    int idx = 0, done = 0, unsent = 0, sent = 0;
+
+    memset(Bit_Count, 0, sizeof(Bit_Count));
+    Reset_Bits = 0;
+    for (long bursts = 0; bursts < 1000000; bursts++)
+    {
+        for (int ch = 0; ch < TEST_CHANNELS; ch++)
+        {
+            unsigned v = RGB_WS2812_Buffer[idx + ch];
+            if (v == timing->T0H || v == timing->T1H)
+            {
+                if (unsent)
+                {
+                    printf("waveform: ch%d data in the half never sent\n", ch);
+                    return 1;
+                }
+                if (gap[ch])
+                {
+                    printf("waveform: ch%d data after LOW bits\n", ch);
+                    return 1;
+                }
+                if (Bit_Count[ch] >= TEST_MAX_BITS)
+                    return 1;
+                Bits[ch][Bit_Count[ch]++] = v == timing->T1H;
+            }
+            else if (v == 0)
+            {
+                if (Bit_Count[ch])
+                    gap[ch]++;
+            }
+            else
+            {
+                printf("waveform: ch%d compare value %u\n", ch, v);
+                return 1;
+            }
+        }
+
+        int bits = 0;
+        for (int ch = 0; ch < TEST_CHANNELS; ch++)
+            bits += Bit_Count[ch];
+        Reset_Bits = bits == sent ? Reset_Bits + 1 : 0;
+        sent = bits;
+
+        idx += TEST_CHANNELS;
+        if (idx == half || idx == 2 * half)
+        {
+            if (unsent)
+                return 0;
+            if (done)
+                unsent = 1; // Output stops here, the other half is decoded next
+            else
+            {
+                RGB_Encoder_Fill_Half_Buffer(idx == half ? 0 : 1);
+                done = RGB_Encoder_Frame_Done();
+            }
+            if (idx == 2 * half)
+                idx = 0;
+        }
+    }
+
+    printf("waveform: frame never ends\n");
+    return 1;
+}
+
+int main(void)
+{
+    int fails = 0;
+
+    srand(1);
+    for (int profile = 0; profile < RGB_WS2812_TIMING_PROFILE_COUNT; profile++)
+    {
+        const RGB_WS2812_Timing *timing = &RGB_WS2812_Timing_Profiles[profile];
+        Test_Setup_Encoder(profile);
+
+        for (int it = 0; it < TEST_FRAMES; it++)
+        {
+            Test_Random_Frame(RGB_PIXEL_FORMAT_COUNT, 1);
+            RGB_Encoder_Begin_Frame(Test_Colors, Test_Chains, Test_Chain_Lamps, Test_Formats);
+            if (Play_Frame(timing))
+            {
+                fails++;
+                continue;
+            }
+            for (int ch = 0; ch < TEST_CHANNELS; ch++)
+                fails += Test_Check_Bits("waveform", it, ch, Bits[ch], Bit_Count[ch], 0);
+            if (Reset_Bits < RGB_WS2812_RESET_BITS(timing))
+            {
+                printf("waveform: frame %d has %d reset bits, expected %d\n", it, Reset_Bits, RGB_WS2812_RESET_BITS(timing));
+                fails++;
+            }
+        }
+    }
+
+    printf("waveform: %s, %d profiles x %d frames\n", fails ? "FAIL" : "OK", RGB_WS2812_TIMING_PROFILE_COUNT, TEST_FRAMES);
+    return fails != 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2025 mr258876
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+    Host client of the raw frame stream, bulk OUT endpoint 4 of the vendor interface.
+    Streams a moving rainbow and reports the sustained frame rate and throughput.
+
+    Usage: rgb_stream [lamps] [frames]
+        lamps   Lamps per frame, from lamp 0. Default 256
+        frames  Frames to send, 0 to run until interrupted. Default 1000
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <libusb.h>
+
+#define USBREEZE_VID        0x1D50
+#define USBREEZE_PID        0x6193
+#define STREAM_INTERFACE    4
+#define STREAM_EP           0x04
+#define STREAM_MAX_LAMPS    256     // RGB_LAMP_TOTAL_COUNT with RGB888 storage
+#define STREAM_TIMEOUT_MS   1000
+
+static double now_seconds(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* Hue wheel, 0..767 */
+static void wheel(int pos, uint8_t *rgb)
+{
+    int phase = pos / 256, level = pos % 256;
+    rgb[phase] = 255 - level;
+    rgb[(phase + 1) % 3] = level;
+    rgb[(phase + 2) % 3] = 0;
+}
+
+int main(int argc, char **argv)
+{
+    int lamps = argc > 1 ? atoi(argv[1]) : STREAM_MAX_LAMPS;
+    long frames = argc > 2 ? atol(argv[2]) : 1000;
+    if (lamps <= 0 || lamps > STREAM_MAX_LAMPS)
+    {
+        fprintf(stderr, "lamps must be 1..%d\n", STREAM_MAX_LAMPS);
+        return 2;
+    }
+
+    if (libusb_init(NULL) != 0)
+        return 1;
+
+    libusb_device_handle *dev = libusb_open_device_with_vid_pid(NULL, USBREEZE_VID, USBREEZE_PID);
+    if (dev == NULL)
+    {
+        fprintf(stderr, "USBreeze %04x:%04x not found\n", USBREEZE_VID, USBREEZE_PID);
+        libusb_exit(NULL);
+        return 1;
+    }
+    libusb_set_auto_detach_kernel_driver(dev, 1);
+    if (libusb_claim_interface(dev, STREAM_INTERFACE) != 0)
+    {
+        fprintf(stderr, "Cannot claim interface %d, is the raw frame stream enabled?\n", STREAM_INTERFACE);
+        libusb_close(dev);
+        libusb_exit(NULL);
+        return 1;
+    }
+
+    static uint8_t frame[STREAM_MAX_LAMPS * 3];
+    int len = lamps * 3;
+    long sent_frames = 0, sent_bytes = 0;
+    double start = now_seconds(), report = start;
+
+    for (long f = 0; frames == 0 || f < frames; f++)
+    {
+        for (int i = 0; i < lamps; i++)
+            wheel((i * 768 / lamps + f * 8) % 768, &frame[i * 3]);
+
+        int sent;
+        int rc = libusb_bulk_transfer(dev, STREAM_EP, frame, len, &sent, STREAM_TIMEOUT_MS);
+        if (rc == 0 && len % 64 == 0 && lamps < STREAM_MAX_LAMPS)   // Short of a full buffer in whole packets, end with a zero length packet
+            rc = libusb_bulk_transfer(dev, STREAM_EP, frame, 0, NULL, STREAM_TIMEOUT_MS);
+        if (rc != 0)
+        {
+            fprintf(stderr, "Transfer failed: %s\n", libusb_error_name(rc));
+            break;
+        }
+        sent_frames++;
+        sent_bytes += sent;
+
+        double t = now_seconds();
+        if (t - report >= 1.0)
+        {
+            printf("%.1f fps, %.1f KB/s\n", sent_frames / (t - start), sent_bytes / (t - start) / 1024);
+            report = t;
+        }
+    }
+
+    double elapsed = now_seconds() - start;
+    if (elapsed > 0)
+        printf("%ld frames of %d lamps in %.2f s: %.1f fps, %.1f KB/s\n",
+               sent_frames, lamps, elapsed, sent_frames / elapsed, sent_bytes / elapsed / 1024);
+
+    libusb_release_interface(dev, STREAM_INTERFACE);
+    libusb_close(dev);
+    libusb_exit(NULL);
+    return 0;
+}